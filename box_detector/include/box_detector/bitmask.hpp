@@ -0,0 +1,204 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file bitmask.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace nimbus
+{
+    /**
+     * @brief Packed per pixel flags of an organized frame, 64 pixels per word in raster order
+     */
+    class Bitmask
+    {
+        private:
+            int _width, _height;
+            std::vector<std::uint64_t> _words;
+        public:
+            Bitmask(): _width(0), _height(0){}
+            Bitmask(int width, int height, bool value = false){ reset(width, height, value); }
+            void reset(int width, int height, bool value = false)
+            {
+                _width = width;
+                _height = height;
+                _words.assign((size() + 63) / 64, value ? ~std::uint64_t(0) : 0);
+                clearPadding();
+            }
+            int width() const { return _width; }
+            int height() const { return _height; }
+            std::size_t size() const { return static_cast<std::size_t>(_width) * _height; }
+            bool test(std::size_t i) const { return (_words[i >> 6] >> (i & 63)) & 1; }
+            void set(std::size_t i){ _words[i >> 6] |= std::uint64_t(1) << (i & 63); }
+            void clear(std::size_t i){ _words[i >> 6] &= ~(std::uint64_t(1) << (i & 63)); }
+            void assign(std::size_t i, bool value){ if(value) set(i); else clear(i); }
+            std::vector<std::uint64_t> &words(){ return _words; }
+            const std::vector<std::uint64_t> &words() const { return _words; }
+            /** Bits beyond size() are kept zero */
+            void clearPadding()
+            {
+                const std::size_t tail = size() & 63;
+                if(tail != 0) _words.back() &= (std::uint64_t(1) << tail) - 1;
+            }
+            std::size_t count() const
+            {
+                std::size_t n = 0;
+                for(std::uint64_t w: _words) n += __builtin_popcountll(w);
+                return n;
+            }
+            /** Index of the first set bit, size() if there is none */
+            std::size_t first() const
+            {
+                for(std::size_t k = 0; k < _words.size(); ++k)
+                    if(_words[k]) return (k << 6) + __builtin_ctzll(_words[k]);
+                return size();
+            }
+            /** Calls fn(i) for every set bit in ascending order */
+            template <class Function>
+            void forEach(Function fn) const
+            {
+                forEach(0, _words.size(), fn);
+            }
+            /**
+             * @brief Same as above for the bits of the words [wordBegin, wordEnd). Bands of whole
+             * words can be processed in parallel, clear() and set() stay inside the band.
+             */
+            template <class Function>
+            void forEach(std::size_t wordBegin, std::size_t wordEnd, Function fn) const
+            {
+                for(std::size_t k = wordBegin; k < wordEnd; ++k)
+                {
+                    std::uint64_t w = _words[k];
+                    while(w)
+                    {
+                        fn((k << 6) + __builtin_ctzll(w));
+                        w &= w - 1;
+                    }
+                }
+            }
+            Bitmask &operator&=(const Bitmask &other)
+            {
+                for(std::size_t k = 0; k < _words.size(); ++k) _words[k] &= other._words[k];
+                return *this;
+            }
+            Bitmask &operator|=(const Bitmask &other)
+            {
+                for(std::size_t k = 0; k < _words.size(); ++k) _words[k] |= other._words[k];
+                return *this;
+            }
+            /**
+             * @brief Erosion with a (2 radius + 1) square, pixels outside the grid count as background.
+             * Separable: each pass combines whole words shifted by one column and by one row.
+             */
+            void erode(int radius = 1);
+            /** Dilation with a (2 radius + 1) square */
+            void dilate(int radius = 1);
+            /** Erosion followed by dilation, removes blobs thinner than 2 radius + 1 pixels */
+            void open(int radius = 1){ erode(radius); dilate(radius); }
+            /** Dilation followed by erosion, fills holes thinner than 2 radius + 1 pixels */
+            void close(int radius = 1){ dilate(radius); erode(radius); }
+        private:
+            /** res[i] = this[i - offset], zero filled */
+            void shifted(long offset, std::vector<std::uint64_t> &res) const;
+            /** Bits of every pixel in the given column */
+            void columnMask(int column, std::vector<std::uint64_t> &res) const;
+            void morphology(int radius, bool dilation);
+    };
+}
+
+inline void 
+nimbus::Bitmask::shifted(long offset, std::vector<std::uint64_t> &res) const
+{
+    const long n = static_cast<long>(_words.size());
+    res.assign(_words.size(), 0);
+    const long q = (offset >= 0 ? offset : -offset) >> 6;
+    const int r = static_cast<int>((offset >= 0 ? offset : -offset) & 63);
+    if(offset >= 0)
+    {
+        // Towards higher pixel indices
+        for(long k = n - 1; k >= q; --k)
+        {
+            std::uint64_t w = _words[k - q] << r;
+            if(r != 0 && k - q - 1 >= 0) w |= _words[k - q - 1] >> (64 - r);
+            res[k] = w;
+        }
+    }else{
+        for(long k = 0; k + q < n; ++k)
+        {
+            std::uint64_t w = _words[k + q] >> r;
+            if(r != 0 && k + q + 1 < n) w |= _words[k + q + 1] << (64 - r);
+            res[k] = w;
+        }
+    }
+}
+
+inline void 
+nimbus::Bitmask::columnMask(int column, std::vector<std::uint64_t> &res) const
+{
+    res.assign(_words.size(), 0);
+    for(std::size_t i = column; i < size(); i += _width)
+        res[i >> 6] |= std::uint64_t(1) << (i & 63);
+}
+
+inline void 
+nimbus::Bitmask::morphology(int radius, bool dilation)
+{
+    if(size() == 0 || radius <= 0) return;
+    std::vector<std::uint64_t> first, last, left, right, up, down;
+    // Neighbours across a row border are not neighbours
+    columnMask(0, first);
+    columnMask(_width - 1, last);
+    for(int pass = 0; pass < radius; ++pass)
+    {
+        shifted(1, left);      // left[i] = pixel i - 1
+        shifted(-1, right);    // right[i] = pixel i + 1
+        for(std::size_t k = 0; k < _words.size(); ++k)
+        {
+            const std::uint64_t l = left[k] & ~first[k];
+            const std::uint64_t r = right[k] & ~last[k];
+            _words[k] = dilation ? (_words[k] | l | r) : (_words[k] & l & r);
+        }
+        clearPadding();
+        shifted(_width, up);
+        shifted(-static_cast<long>(_width), down);
+        for(std::size_t k = 0; k < _words.size(); ++k)
+            _words[k] = dilation ? (_words[k] | up[k] | down[k]) : (_words[k] & up[k] & down[k]);
+        clearPadding();
+    }
+}
+
+inline void 
+nimbus::Bitmask::erode(int radius)
+{
+    morphology(radius, false);
+}
+
+inline void 
+nimbus::Bitmask::dilate(int radius)
+{
+    morphology(radius, true);
+}
@@ -26,21 +26,29 @@
  */
 
 #pragma once
+#include <limits>
 #include <boost/filesystem.hpp>
-#include <ros/ros.h>
-#include <visualization_msgs/Marker.h>
+#include <boost/shared_ptr.hpp>
 
-#include <pcl_ros/point_cloud.h>
-#include <pcl_conversions/pcl_conversions.h>
-#include <pcl/io/pcd_io.h>
-#include <boost/foreach.hpp>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
 #include <pcl/io/impl/synchronized_queue.hpp>
-#include <tf2_ros/transform_listener.h>
-#include <geometry_msgs/TransformStamped.h>
-
-#include <pcl/search/search.h>
 #include <pcl/common/common.h>
 
+#include <box_detector/depth_frame.hpp>
+#include <box_detector/soa_frame.hpp>
+#include <box_detector/robust_plane.hpp>
+#include <box_detector/cuboid.hpp>
+#include <box_detector/contour.hpp>
+#include <box_detector/cuboid_refiner.hpp>
+
+/**
+ * The detector core is kept free of any ROS dependency so that it can be
+ * driven from an offline loop (see box_detector_batch.cpp) as well as from
+ * the ROS adapter in box_detector_node.cpp. Failures are reported through
+ * the return values only, the caller decides what to log.
+ */
+
 #define hypotenuse(x, y) (sqrt((x * x) + (y * y)))
 #define slope(x1, y1, x2, y2) ((y2 - y1)/(x2 - x1))
 
@@ -49,25 +57,40 @@ enum class Side: unsigned char{
     WIDTH = 1,
 };
 
+enum class YawMethod: unsigned char{
+    CORNERS = 0,        // Extreme corners averaged over several frames (boxYaw)
+    MIN_AREA_RECT = 1,  // Minimum area rectangle of the top face of a single frame (boxYawMinAreaRect)
+    CUBOID = 2,         // Full orientation and measured dimensions of a single frame (boxCuboid)
+    CONTOUR = 3,        // Line fit of the traced top face contour of a single frame (boxYawContour)
+};
+
 namespace nimbus
 {
     template <class PointType>
     class BoxDetector
     {
         private:
-            visualization_msgs::Marker _marker;
-            uint32_t _shape = visualization_msgs::Marker::CUBE;
             EIGEN_ALIGN32 Eigen::Matrix<float, 4, 2> cornerBuffer;
             int cornerBufferCounter;
         protected:
-            ros::NodeHandle _nh;
-            ros::Publisher _pub_marker;
             EIGEN_ALIGN16 Eigen::Matrix3f _covariance_matrix;
             Eigen::Vector4f _centroid;
             Side sideSelect;
             std::vector<std::pair<float, int> > _meanYaw;
+            RowBands _bands;
+            RobustPlane _robustPlane;
+            CuboidRefiner _refiner;
         public:
-            BoxDetector(ros::NodeHandle nh);
+            BoxDetector();
+            /**
+             * @brief Row band parallelism of the per pixel stages
+             * @param threads Number of threads, 0 selects the hardware concurrency
+             * @param deterministic Fixed band split, results do not depend on the thread count
+             */
+            void setParallel(unsigned int threads, bool deterministic)
+            {
+                _bands = RowBands(threads, deterministic);
+            }
             ~BoxDetector();
             /**
              * @brief Remove the points on the basis of Z Axis distace
@@ -80,6 +103,22 @@ namespace nimbus
                               double max, double min,
                               pcl::PointCloud<pcl::PointXYZ> &res);
 
+            /**
+             * @brief Same as above as packed foreground mask, no cloud copies
+             * @param frame Planar frame
+             * @param max Maximum distance
+             * @param min Minimum distance
+             * @param mask Valid pixels of the frame within [min, max]
+             */
+            void zAxisLimiter(const SoAFrame &frame, double max, double min, Bitmask &mask);
+
+            /**
+             * @brief Crop the border of an organized frame
+             * @param blob Organized frame
+             * @param width, height Layout of blob
+             * @param perW, perH Part of the width and height that is cut off, half on each side
+             * @param res Organized window of the remaining rows and columns
+             */
             void outlineRemover(const boost::shared_ptr< const pcl::PointCloud<PointType>> blob, 
                                 int width, int height, float perW, float perH,
                                 pcl::PointCloud<PointType> &res);
@@ -90,6 +129,36 @@ namespace nimbus
                           const boost::filesystem::path &path,
                           pcl::PointCloud<pcl::PointXYZ> &res);
 
+            /**
+             * @brief Background subtraction in depth space, XYZ is only reconstructed for the foreground
+             * @param ground Depth frame of the empty table
+             * @param raw Current (mean) depth frame
+             * @param tolerence Minimum height above the table in meter
+             * @param res Organized foreground cloud, NaN elsewhere
+             * @return false if the frames do not have the same layout
+             */
+            bool getBaseModel(const DepthFrame &ground, const DepthFrame &raw, double tolerence,
+                              pcl::PointCloud<pcl::PointXYZ> &res);
+
+            /**
+             * @brief Same as above as packed foreground mask over the organized grid
+             * @param mask Foreground pixels
+             */
+            bool getBaseModel(const DepthFrame &ground, const DepthFrame &raw, double tolerence,
+                              Bitmask &mask);
+
+            /**
+             * @brief Same as above into the planar frame, the foreground is the validity mask
+             * @param res Organized foreground frame
+             */
+            bool getBaseModel(const DepthFrame &ground, const DepthFrame &raw, double tolerence,
+                              SoAFrame &res);
+
+            /**
+             * @brief Per pixel mean of the queued frames, the queue is emptied
+             * @param queue Frames of the same layout, frames of another layout than the first are skipped
+             * @param res Mean of the finite samples of every pixel, NaN if a pixel has none
+             */
             void meanFilter(pcl::SynchronizedQueue<pcl::PointCloud<pcl::PointXYZ>> &queue, pcl::PointCloud<pcl::PointXYZ> &res);
 
             /**
@@ -105,6 +174,14 @@ namespace nimbus
              *                \--                --
              */
             bool getMeanCorners(const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob, int frameSize);
+            /**
+             * @brief Same as above, only the set bits of mask are visited
+             * @param frame Planar frame
+             * @param mask Pixels of the box, e.g. the opened foreground of one blob
+             */
+            bool getMeanCorners(const SoAFrame &frame, const Bitmask &mask, int frameSize);
+            /** Adds the extreme corners of one frame to cornerBuffer, true once frameSize frames are averaged */
+            bool accumulateCorners(const Eigen::Matrix<float, 4, 2> &corners, int frameSize);
             /**
              * @brief Compute the Least-Squares plane fit for a given set of points, using their indices,
              * and return the estimated plane parameters together with the surface curvature. 
@@ -114,10 +191,40 @@ namespace nimbus
              */
             bool computePointNormal(const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob,
                                     Eigen::Vector4f &plane_parameters, float &curvature);
+            /**
+             * @brief Robust top face plane of the masked pixels, edges, side faces and flying
+             * pixels are rejected as outliers before the least-squares refit.
+             * @param frame Planar frame
+             * @param mask Pixels of the box
+             * @param plane_parameters the plane parameters as: a, b, c, d, normal towards the camera
+             * @param curvature the curvature of the inliers
+             */
+            bool computePointNormal(const SoAFrame &frame, const Bitmask &mask,
+                                    Eigen::Vector4f &plane_parameters, float &curvature);
+            /** Parameters of the robust plane estimator, see RobustPlane */
+            void setRobustPlane(float threshold, float confidence, int maxIterations,
+                                std::size_t maxPoints, PlaneEstimator estimator)
+            {
+                _robustPlane.setParameter(threshold, confidence, maxIterations, maxPoints, estimator);
+            }
 
+            /**
+             * @brief Mean of all finite points of the blob
+             * @param blob Organized (non dense) cloud
+             * @param centroid Resulting centroid, set to NaN if it can not be computed
+             */
             void box3DCentroid(const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob,
                                Eigen::Matrix<float, 4, 1> &centroid);
 
+            /**
+             * @brief Mean of the valid pixels of the frame selected by mask
+             * @param frame Planar frame
+             * @param mask Pixel selection, e.g. one segmented blob
+             * @param centroid Resulting centroid, set to NaN if it can not be computed
+             */
+            void box3DCentroid(const SoAFrame &frame, const Bitmask &mask,
+                               Eigen::Matrix<float, 4, 1> &centroid);
+
             unsigned int boxCovarianceMatrix (const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob,
                                           const Eigen::Matrix<float, 4, 1> &centroid,
                                           Eigen::Matrix<float, 3, 3> &covariance_matrix);
@@ -137,10 +244,94 @@ namespace nimbus
             void solveBoxParameters (const Eigen::Matrix3f &covariance_matrix,
                                        float &nx, float &ny, float &nz, float &curvature);
             
+            /**
+             * @brief Yaw of the box around the camera z axis from the averaged extreme corners
+             * @param blob Foreground cloud of the box
+             * @param width Box width
+             * @param length Box length
+             * @param centroid Box centroid
+             * @param yaw Resulting yaw in radian
+             * @return false as long as the corner buffer is not filled
+             */
             bool boxYaw(const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob, 
                         const float width, const float length,
                         const Eigen::Vector4f &centroid,
                         float &yaw);
+            /**
+             * @brief Same as above on the pixels of mask
+             */
+            bool boxYaw(const SoAFrame &frame, const Bitmask &mask,
+                        const float width, const float length,
+                        const Eigen::Vector4f &centroid,
+                        float &yaw);
+            /** Yaw from the averaged corners in cornerBuffer, empties the buffer */
+            bool yawFromMeanCorners(const float width, const float length,
+                                    const Eigen::Vector4f &centroid,
+                                    float &yaw);
+            /**
+             * @brief Single frame yaw, length and width from the minimum area rectangle of the top face.
+             * The top face is projected onto the table plane, its convex hull is enclosed with rotating calipers.
+             * @param blob Foreground cloud of the box
+             * @param normal Table normal pointing away from the camera, (0, 0, 1) for a camera looking down
+             * @param topTolerance Points within this distance of the top face are used
+             * @param yaw Resulting yaw in radian, same convention as boxYaw
+             * @param length Measured length of the top face
+             * @param width Measured width of the top face
+             * @return false if the top face has less than three hull points
+             */
+            bool boxYawMinAreaRect(const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob,
+                                   const Eigen::Vector3f &normal, float topTolerance,
+                                   float &yaw, float &length, float &width);
+            /**
+             * @brief Yaw from the sides of the traced contour of the box mask, only the boundary
+             * pixels are visited and no corners are averaged over frames, see contourYaw.
+             * @param frame Planar frame
+             * @param mask Pixels of the box
+             * @param normal Top face normal pointing away from the camera
+             * @param yaw Resulting yaw in radian, same convention as boxYaw
+             * @param length Measured length of the outline
+             * @param width Measured width of the outline
+             * @return false if the contour is too short
+             */
+            bool boxYawContour(const SoAFrame &frame, const Bitmask &mask, const Eigen::Vector3f &normal,
+                               float &yaw, float &length, float &width)
+            {
+                float support;
+                return nimbus::contourYaw(frame, mask, normal, yaw, length, width, support);
+            }
+            /**
+             * @brief Full pose and dimensions of one box in one pass: robust top face plane,
+             * minimum area rectangle of the top face pixels and the height above the table.
+             * Tilted boxes keep their roll and pitch instead of being forced onto the table normal.
+             * @param frame Planar frame
+             * @param mask Pixels of the box
+             * @param table Table plane with unit normal, NaN if unknown
+             * @param cuboid Result, see Cuboid
+             * @return false if the top face can not be fitted
+             */
+            bool boxCuboid(const SoAFrame &frame, const Bitmask &mask, const Eigen::Vector4f &table, Cuboid &cuboid);
+            /**
+             * @brief boxCuboid on a top face plane that is already fitted, e.g. by computePointNormal
+             * @param top Top face plane of the masked pixels, normal towards the camera
+             */
+            bool boxCuboid(const SoAFrame &frame, const Bitmask &mask, const Eigen::Vector4f &top,
+                           const Eigen::Vector4f &table, Cuboid &cuboid);
+            /**
+             * @brief Pose refinement of a measured cuboid on the depth of the masked pixels, see CuboidRefiner
+             * @return false without height or with too few inliers, cuboid is unchanged then. A refinement
+             * that is still moving after the last iteration returns true, see CuboidRefiner::converged
+             */
+            bool refineCuboid(const SoAFrame &frame, const Bitmask &mask, Cuboid &cuboid)
+            {
+                return _refiner.refine(frame, mask, cuboid);
+            }
+            /** Parameters of the cuboid refinement, see CuboidRefiner */
+            void setCuboidRefiner(int maxIterations, float outlierDistance, float huber, float damping)
+            {
+                _refiner.setParameter(maxIterations, outlierDistance, huber, damping);
+            }
+            /** The cuboid refinement of the last refineCuboid call */
+            const CuboidRefiner &cuboidRefiner() const { return _refiner; }
             void slopeWRTCoordinate(const float x1, const float y1, const float x2, const float y2, float &angle);
             void selectBestCorner(const float diagonal, const Eigen::Matrix<float, 4, 2> corners, 
                                   const Eigen::Vector4f &centroid, unsigned int &best);
@@ -0,0 +1,103 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file box_segmentation.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/common.h>
+
+namespace nimbus
+{
+    /**
+     * @brief Statistics of one connected foreground region (one box candidate)
+     */
+    struct BoxBlob
+    {
+        std::vector<int> indices;       // Indices into the organized foreground cloud
+        Eigen::Vector4f centroid;
+        Eigen::Matrix3f covariance;
+        float yaw;                      // Principal axis of the blob in the camera x-y plane
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+    typedef std::vector<BoxBlob, Eigen::aligned_allocator<BoxBlob> > BoxBlobs;
+
+    /**
+     * @brief Splits the foreground of an organized cloud into connected regions
+     * so that several boxes on the table are detected independently.
+     * @tparam PointType 
+     */
+    template <class PointType>
+    class BoxSegmentation
+    {
+        private:
+            std::vector<int> _parent;
+            float _depthJump;
+            unsigned int _minPoints;
+
+            int findRoot(int label);
+            void unite(int a, int b);
+        public:
+            BoxSegmentation(float depth_jump = 0.01f, unsigned int min_points = 50);
+            ~BoxSegmentation();
+
+            void setDepthJump(float depth_jump){ _depthJump = depth_jump; }
+            void setMinPoints(unsigned int min_points){ _minPoints = min_points; }
+
+            /**
+             * @brief Connected component labelling of the finite points in a single raster
+             * pass with union-find. Two 4-neighbours are connected if their depth differs
+             * less than the depth jump.
+             * @param blob Organized foreground cloud (rejected points are NaN)
+             * @param labels Label per point, -1 for background
+             * @return Number of labels, 0 if the cloud is not organized
+             */
+            unsigned int label(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob,
+                               std::vector<int> &labels);
+
+            /**
+             * @brief Label the foreground and compute centroid, covariance and yaw per region.
+             * Regions smaller than the minimum number of points are dropped.
+             * @param blob Organized foreground cloud
+             * @param blobs Resulting regions sorted by size, largest first
+             */
+            void extractBlobs(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob,
+                              BoxBlobs &blobs);
+
+            /**
+             * @brief Organized copy of the cloud that keeps only the points of one region
+             * @param blob Organized foreground cloud
+             * @param box Region from extractBlobs
+             * @param res Resulting cloud, non dense
+             */
+            void blobCloud(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob,
+                           const BoxBlob &box,
+                           pcl::PointCloud<PointType> &res);
+    };
+} // namespace nimbus
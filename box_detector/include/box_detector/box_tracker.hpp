@@ -0,0 +1,113 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file box_tracker.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <Eigen/Core>
+
+namespace nimbus
+{
+    /**
+     * @brief Constant velocity Kalman filter on the box pose x, y, z and yaw.
+     * State: [x y z yaw vx vy vz vyaw]. The top face of a box is symmetric by 180 degree,
+     * therefore yaw and the yaw innovation are wrapped to [-pi/2, pi/2).
+     * A measurement outside the innovation gate belongs to another box and restarts the track.
+     * Time stamps are in seconds, the filter does not depend on ROS.
+     */
+    class BoxTracker
+    {
+        public:
+            typedef Eigen::Matrix<double, 8, 1> State;
+            typedef Eigen::Matrix<double, 8, 8> Covariance;
+        private:
+            State _x;
+            Covariance _P;
+            double _stamp;
+            bool _initialized;
+            // Process noise (white acceleration spectral density) and measurement noise (std. deviation)
+            double _qPos, _qYaw, _rPos, _rYaw;
+            // Restart the track if no measurement is received for this long
+            double _timeout;
+            // Largest squared Mahalanobis distance of the innovation, 0 disables the gate
+            double _gate;
+
+            void initialize(double stamp, const Eigen::Vector3d &position, double yaw, bool hasYaw);
+            void propagate(double dt, State &x, Covariance &P) const;
+            /** Kalman correction, false without change if the innovation is outside the gate */
+            template <int M>
+            bool correct(const Eigen::Matrix<double, M, 1> &innovation,
+                         const Eigen::Matrix<double, M, 8> &H,
+                         const Eigen::Matrix<double, M, M> &R);
+        public:
+            BoxTracker(double q_pos = 0.01, double q_yaw = 0.05, double r_pos = 0.005, double r_yaw = 0.05,
+                       double timeout = 2.0, double gate = 20.0);
+            ~BoxTracker();
+
+            void setNoise(double q_pos, double q_yaw, double r_pos, double r_yaw);
+            void setTimeout(double timeout){ _timeout = timeout; }
+            void setGate(double gate){ _gate = gate; }
+            void reset(){ _initialized = false; }
+            bool isInitialized() const { return _initialized; }
+
+            /**
+             * @brief Position only measurement, e.g. while the corner based yaw is still averaging
+             * @param stamp Sensor time stamp of the frame
+             * @param position Measured box centroid
+             */
+            void update(double stamp, const Eigen::Vector3d &position);
+            /**
+             * @brief Full measurement
+             * @param stamp Sensor time stamp of the frame
+             * @param position Measured box centroid
+             * @param yaw Measured yaw in radian
+             */
+            void update(double stamp, const Eigen::Vector3d &position, double yaw);
+
+            /**
+             * @brief Predicted state for an arbitrary time, the filter itself is not modified
+             * @param stamp Time of the prediction, usually in the future
+             * @param state Predicted state
+             * @param covariance Predicted covariance
+             * @return false if the tracker is not initialized or no measurement was received within the timeout
+             */
+            bool predict(double stamp, State &state, Covariance &covariance) const;
+            /**
+             * @brief Squared Mahalanobis distance of a position measurement to the predicted track,
+             * used to pick the measurement of the tracked box among several boxes
+             * @return infinity if there is no live track
+             */
+            double distance(double stamp, const Eigen::Vector3d &position) const;
+
+            const State &state() const { return _x; }
+            const Covariance &covariance() const { return _P; }
+            double stamp() const { return _stamp; }
+
+            /** Wrap an angle to [-pi/2, pi/2) */
+            static double wrapYaw(double yaw);
+
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+} // namespace nimbus
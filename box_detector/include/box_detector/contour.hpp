@@ -0,0 +1,75 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file contour.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <box_detector/bitmask.hpp>
+#include <box_detector/soa_frame.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Outer boundary of the region that contains the first set pixel, traced with the
+     * Moore neighbourhood (8-connected) in clockwise order. Only boundary pixels are visited.
+     * @param mask Region mask of an organized frame
+     * @param contour Pixel indices, empty if the mask is empty
+     */
+    void traceContour(const Bitmask &mask, std::vector<int> &contour);
+
+    /**
+     * @brief Dominant edge direction of a closed rectangular outline. Directions of chords
+     * spanning step points are voted into a Hough accumulator modulo 90 deg (both side pairs
+     * of a rectangle vote for the same bin). The peak is refined by a line fit of every side,
+     * the points of a side are the ones near the bounding rectangle along the peak.
+     * @param outline Ordered closed outline
+     * @param step Chord length in points, longer chords are less quantized by the pixel grid
+     * @param angle Resulting direction in [0, pi/2)
+     * @param support Fraction of the outline points on a fitted side
+     * @return false if the outline is shorter than two chords
+     */
+    bool dominantDirection(const std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f> > &outline,
+                           int step, float &angle, float &support);
+
+    /**
+     * @brief Yaw of a box from its top face contour in a single frame, no corner averaging.
+     * The contour is lifted to 3D, projected onto the plane perpendicular to normal and the
+     * longer of the two dominant directions is the length side.
+     * @param frame Planar frame
+     * @param mask Pixels of the box
+     * @param normal Top face normal pointing away from the camera, (0, 0, 1) for a camera looking down
+     * @param yaw Resulting yaw in radian, same convention as boxYaw
+     * @param length Extent along the length side
+     * @param width Extent along the width side
+     * @param support Fraction of the contour following the two directions
+     * @return false if the contour is too short
+     */
+    bool contourYaw(const SoAFrame &frame, const Bitmask &mask, const Eigen::Vector3f &normal,
+                    float &yaw, float &length, float &width, float &support);
+}
@@ -0,0 +1,67 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file cuboid.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <Eigen/Geometry>
+
+#include <box_detector/bitmask.hpp>
+#include <box_detector/soa_frame.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Measured box in the camera frame. Axes: x along the width, y along the length
+     * (same as the marker and boxYaw), z into the box, away from the camera.
+     */
+    struct Cuboid
+    {
+        Eigen::Vector3f center;             // Center of the volume, the top face center without table
+        Eigen::Vector3f topCenter;          // Center of the top face
+        Eigen::Quaternionf orientation;
+        float length;
+        float width;
+        float height;                       // NaN without table plane
+        float yaw;                          // Yaw of the length side, same convention as boxYaw
+        float tilt;                         // Angle between top face and table (camera axis without table) in radian
+        float quality;                      // Top face inlier ratio times hull to rectangle area ratio, [0, 1]
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    /**
+     * @brief Cuboid from the top face plane, the table plane and the minimum area rectangle of the
+     * top face. The top face pixels are the masked pixels within inlierDistance of topPlane.
+     * @param frame Planar frame
+     * @param mask Pixels of one box
+     * @param topPlane Top face a, b, c, d with unit normal towards the camera (RobustPlane)
+     * @param table Table plane with unit normal, NaN if unknown (no height then)
+     * @param inlierDistance Top face thickness in meter
+     * @param res Result
+     * @return false if the top face has less than three hull points
+     */
+    bool estimateCuboid(const SoAFrame &frame, const Bitmask &mask, const Eigen::Vector4f &topPlane,
+                        const Eigen::Vector4f &table, float inlierDistance, Cuboid &res);
+}
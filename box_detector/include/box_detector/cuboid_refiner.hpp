@@ -0,0 +1,93 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file cuboid_refiner.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <Eigen/Core>
+
+#include <box_detector/bitmask.hpp>
+#include <box_detector/soa_frame.hpp>
+#include <box_detector/cuboid.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Refines the pose of a cuboid directly on the organized depth. The range of every
+     * ROI pixel is rendered by a ray/box slab test of the hypothesis and the range residuals are
+     * minimized by damped Gauss-Newton in the 6 pose parameters. Rendering, Jacobians and the
+     * normal equations are evaluated on compact arrays (vectorized by Eigen), there is no
+     * nearest neighbour search. Only visible faces constrain the pose: lateral position and yaw
+     * need visible side faces, otherwise the damping keeps them at the coarse estimate.
+     */
+    class CuboidRefiner
+    {
+        private:
+            typedef Eigen::Array<float, Eigen::Dynamic, 1> Array;
+            int _maxIterations;
+            float _outlierDistance;
+            float _huber;
+            float _damping;
+            // Unit rays and measured range of the ROI pixels
+            Array _dx, _dy, _dz, _range;
+            // Weighted residual, square root of the weight, slab test and Jacobian per pixel
+            enum { WORK_COLUMNS = 16 };
+            Array _e, _w;
+            Eigen::Array<float, Eigen::Dynamic, WORK_COLUMNS> _work;
+            Eigen::Matrix<float, Eigen::Dynamic, 6> _J;
+            int _iterations;
+            bool _converged;
+            std::size_t _inliers;
+            float _rms;
+        public:
+            /**
+             * @param maxIterations Gauss-Newton iterations
+             * @param outlierDistance Pixels whose range differs more from the rendering are ignored
+             * @param huber Residuals above this are down weighted (Huber)
+             * @param damping Levenberg damping relative to the mean diagonal of the normal equations
+             */
+            CuboidRefiner(int maxIterations = 10, float outlierDistance = 0.02f, float huber = 0.002f,
+                          float damping = 1e-3f);
+            ~CuboidRefiner();
+            void setParameter(int maxIterations, float outlierDistance, float huber, float damping);
+            /**
+             * @brief Refine center, topCenter and orientation of cuboid, the dimensions are kept
+             * @param frame Planar frame
+             * @param roi Pixels compared with the rendering, e.g. the dilated box mask
+             * @param cuboid Coarse pose in, refined pose out (unchanged on failure). Without
+             * convergence it is the pose after maxIterations, see converged
+             * @return false without finite height or with less than six inliers
+             */
+            bool refine(const SoAFrame &frame, const Bitmask &roi, Cuboid &cuboid);
+            /** Iterations of the last refinement */
+            int iterations() const { return _iterations; }
+            /** The last refinement stopped on a small step, not on maxIterations */
+            bool converged() const { return _converged; }
+            /** Pixels within outlierDistance of the final rendering */
+            std::size_t inliers() const { return _inliers; }
+            /** Root mean square range residual of the inliers in meter */
+            float rms() const { return _rms; }
+    };
+}
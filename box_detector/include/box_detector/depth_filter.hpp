@@ -0,0 +1,189 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file depth_filter.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/common.h>
+
+#include <nimbus_common/parallel.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Edge preserving smoothing of an organized cloud in the depth image.
+     * A separable bilateral filter (row pass, then column pass) runs on z only,
+     * x and y are moved along the pixel ray (x/z, y/z stays constant).
+     * Depth steps larger than a few sigma_depth are not blurred, so box edges stay sharp.
+     * Both passes run in parallel over row bands.
+     * @tparam PointType 
+     */
+    template <class PointType>
+    class DepthBilateral
+    {
+        private:
+            int _radius;
+            float _sigmaDepth;
+            unsigned int _threads;
+            std::vector<float> _spatial;
+            std::vector<float> _tmp;
+            void spatialKernel(float sigma_space);
+            /** One 1D pass, step 1 is along a row and step width along a column */
+            void pass(const float *in, float *out, int width, int height, bool rows);
+        public:
+            /**
+             * @param radius Half kernel size in pixel
+             * @param sigma_space Spatial sigma in pixel
+             * @param sigma_depth Range sigma in meter
+             * @param threads Worker threads, 0 selects the hardware concurrency 
+             */
+            DepthBilateral(int radius = 2, float sigma_space = 1.5f, float sigma_depth = 0.01f, unsigned int threads = 0);
+            ~DepthBilateral();
+            void setParameter(int radius, float sigma_space, float sigma_depth);
+            void setThreads(unsigned int threads){ _threads = threads; }
+            /**
+             * @brief Filter the organized cloud, NaN pixels stay NaN
+             * @param blob Organized input cloud
+             * @param res Smoothed cloud with the same layout, other fields are copied
+             * @return false if the input is not organized, res is a copy of the input then
+             */
+            bool filter(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res);
+    };
+}
+
+template <class PointType>
+nimbus::DepthBilateral<PointType>::DepthBilateral(int radius, float sigma_space, float sigma_depth, unsigned int threads): _threads(threads)
+{
+    setParameter(radius, sigma_space, sigma_depth);
+}
+template <class PointType>
+nimbus::DepthBilateral<PointType>::~DepthBilateral(){}
+
+template <class PointType>
+void 
+nimbus::DepthBilateral<PointType>::setParameter(int radius, float sigma_space, float sigma_depth)
+{
+    _radius = radius < 0 ? 0 : radius;
+    _sigmaDepth = sigma_depth;
+    spatialKernel(sigma_space);
+}
+
+template <class PointType>
+void 
+nimbus::DepthBilateral<PointType>::spatialKernel(float sigma_space)
+{
+    _spatial.resize(2 * _radius + 1);
+    for(int k = -_radius; k <= _radius; ++k)
+        _spatial[k + _radius] = std::exp(-(k * k) / (2.0f * sigma_space * sigma_space));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+void 
+nimbus::DepthBilateral<PointType>::pass(const float *in, float *out, int width, int height, bool rows)
+{
+    const float rangeScale = -1.0f / (2.0f * _sigmaDepth * _sigmaDepth);
+    // Beyond 3 sigma the range weight is below 1.2 %, treat it as a depth edge
+    const float cutoff = 9.0f * _sigmaDepth * _sigmaDepth;
+    const int radius = _radius;
+    const float *spatial = _spatial.data();
+    parallelFor(height, hardwareThreads(_threads), [&](std::size_t begin, std::size_t end, unsigned int){
+        for(int r = static_cast<int>(begin); r < static_cast<int>(end); ++r)
+        {
+            for(int c = 0; c < width; ++c)
+            {
+                const int i = r * width + c;
+                const float z0 = in[i];
+                if(std::isnan(z0))
+                {
+                    out[i] = z0;
+                    continue;
+                }
+                float sum = 0, weight = 0;
+                for(int k = -radius; k <= radius; ++k)
+                {
+                    int j;
+                    if(rows)
+                    {
+                        if(c + k < 0 || c + k >= width) continue;
+                        j = i + k;
+                    }else{
+                        if(r + k < 0 || r + k >= height) continue;
+                        j = i + k * width;
+                    }
+                    const float z = in[j];
+                    const float d2 = (z - z0) * (z - z0);
+                    // NaN fails the comparison as well
+                    if(!(d2 < cutoff)) continue;
+                    const float w = spatial[k + radius] * std::exp(d2 * rangeScale);
+                    sum += w * z;
+                    weight += w;
+                }
+                out[i] = sum / weight;
+            }
+        }
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+bool 
+nimbus::DepthBilateral<PointType>::filter(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res)
+{
+    const int width = blob->width;
+    const int height = blob->height;
+    if(height < 2 || static_cast<std::size_t>(width) * height != blob->points.size())
+    {
+        if(&res != blob.get()) res = *blob;
+        return false;
+    }
+    const std::size_t size = blob->points.size();
+    std::vector<float> depth(size);
+    for(std::size_t i = 0; i < size; ++i)
+        depth[i] = pcl::isFinite(blob->points[i]) ? blob->points[i].z : std::numeric_limits<float>::quiet_NaN();
+    _tmp.resize(size);
+    pass(depth.data(), _tmp.data(), width, height, true);
+    std::vector<float> smooth(size);
+    pass(_tmp.data(), smooth.data(), width, height, false);
+
+    if(&res != blob.get()) res = *blob;
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        if(std::isnan(smooth[i]) || depth[i] == 0) continue;
+        // Same pixel ray, new range
+        const float scale = smooth[i] / depth[i];
+        res.points[i].x *= scale;
+        res.points[i].y *= scale;
+        res.points[i].z = smooth[i];
+    }
+    return true;
+}
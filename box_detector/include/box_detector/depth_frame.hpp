@@ -0,0 +1,227 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file depth_frame.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/io/impl/synchronized_queue.hpp>
+#include <pcl/common/common.h>
+
+#include <nimbus_common/parallel.hpp>
+
+namespace nimbus
+{
+    /** Amplitude of a point, zero for point types without intensity */
+    template <class PointType>
+    inline float pointAmplitude(const PointType &){ return 0.0f; }
+    inline float pointAmplitude(const pcl::PointXYZI &point){ return point.intensity; }
+    template <class PointType>
+    inline void setPointAmplitude(PointType &, float){}
+    inline void setPointAmplitude(pcl::PointXYZI &point, float amplitude){ point.intensity = amplitude; }
+
+    /**
+     * @brief Per pixel viewing ray of the sensor, scaled to z = 1 so that xyz = depth * (rx, ry, 1).
+     * The rays are learned from the first finite sample of every pixel; a pixel that has never
+     * been valid has no ray yet. Known rays never change, frames can share one table.
+     */
+    class RayTable
+    {
+        private:
+            int _width, _height;
+            std::size_t _unknown;
+            std::vector<float> _rayX, _rayY;
+        public:
+            typedef boost::shared_ptr<RayTable> Ptr;
+            typedef boost::shared_ptr<const RayTable> ConstPtr;
+            RayTable();
+            ~RayTable();
+            /** All rays unknown */
+            void reset(int width, int height);
+            /**
+             * @brief Learn the rays of the finite points that are still unknown, resets on a size change
+             * @param cloud Organized cloud of the sensor
+             */
+            template <class PointType>
+            void update(const pcl::PointCloud<PointType> &cloud);
+            /** Learn the ray of one pixel from a finite point, known rays are kept */
+            void learn(std::size_t i, float x, float y, float z)
+            {
+                if(known(i) || !(z > 0)) return;
+                _rayX[i] = x / z;
+                _rayY[i] = y / z;
+                --_unknown;
+            }
+            bool matches(int width, int height) const { return _width == width && _height == height; }
+            bool known(std::size_t i) const { return !std::isnan(_rayX[i]); }
+            std::size_t unknown() const { return _unknown; }
+            int width() const { return _width; }
+            int height() const { return _height; }
+            float rayX(std::size_t i) const { return _rayX[i]; }
+            float rayY(std::size_t i) const { return _rayY[i]; }
+    };
+
+    /**
+     * @brief Compact organized frame: quantized depth and amplitude, 4 byte per pixel instead of
+     * 16/32 byte PCL points. XYZ is reconstructed from the shared ray table only where needed.
+     * A depth of 0 marks an invalid pixel.
+     */
+    class DepthFrame
+    {
+        private:
+            int _width, _height;
+            float _scale;
+            std::vector<std::uint16_t> _depth;
+            std::vector<std::uint16_t> _amplitude;
+            RayTable::ConstPtr _rays;
+        public:
+            /** 0.1 mm steps, up to 6.5 m */
+            static constexpr float DEFAULT_SCALE = 0.0001f;
+            pcl::PCLHeader header;
+
+            DepthFrame();
+            ~DepthFrame();
+            /** Empty frame of the given layout, all pixels invalid */
+            void reset(int width, int height, const RayTable::ConstPtr &rays, float scale = DEFAULT_SCALE);
+            /**
+             * @brief Quantize a cloud, pixels without a known ray are invalid
+             * @param cloud Organized cloud with the layout of the ray table
+             * @param rays Ray table updated with this cloud
+             * @param scale Depth step in meter
+             * @return false if the layout does not match the ray table
+             */
+            template <class PointType>
+            bool fromCloud(const pcl::PointCloud<PointType> &cloud, const RayTable::ConstPtr &rays, float scale = DEFAULT_SCALE);
+            /** Full organized cloud, NaN for invalid pixels */
+            template <class PointType>
+            void toCloud(pcl::PointCloud<PointType> &res) const;
+            /**
+             * @brief Reconstruct only the given pixels
+             * @param indices Valid pixel indices
+             * @param xyz One column per index
+             */
+            void points(const std::vector<int> &indices, Eigen::Matrix3Xf &xyz) const;
+            Eigen::Vector3f point(std::size_t i) const
+            {
+                const float z = depth(i);
+                return Eigen::Vector3f(z * _rays->rayX(i), z * _rays->rayY(i), z);
+            }
+            bool isValid(std::size_t i) const { return _depth[i] != 0; }
+            float depth(std::size_t i) const { return _depth[i] * _scale; }
+            float amplitude(std::size_t i) const { return _amplitude[i]; }
+            std::uint16_t rawDepth(std::size_t i) const { return _depth[i]; }
+            void setRaw(std::size_t i, std::uint16_t depth, std::uint16_t amplitude)
+            {
+                _depth[i] = depth;
+                _amplitude[i] = amplitude;
+            }
+            /** Quantize a depth in meter, 0 if not representable */
+            std::uint16_t quantize(float depth) const;
+            int width() const { return _width; }
+            int height() const { return _height; }
+            std::size_t size() const { return _depth.size(); }
+            float scale() const { return _scale; }
+            const RayTable::ConstPtr &rays() const { return _rays; }
+            /** Memory of the pixel data in byte */
+            std::size_t bytes() const { return _depth.size() * 2 * sizeof(std::uint16_t); }
+    };
+
+    /**
+     * @brief Per pixel mean depth and amplitude of all queued frames, invalid samples are skipped.
+     * The rays are fixed per pixel, so this equals the XYZ mean.
+     * @param queue Frames of the same layout, emptied
+     * @param res Mean frame
+     * @param config Row band split, integer sums so the result does not depend on it
+     * @return false if the queue is empty
+     */
+    bool meanDepth(pcl::SynchronizedQueue<DepthFrame> &queue, DepthFrame &res, const RowBands &config = RowBands());
+}
+
+template <class PointType>
+void 
+nimbus::RayTable::update(const pcl::PointCloud<PointType> &cloud)
+{
+    if(!matches(cloud.width, cloud.height)) reset(cloud.width, cloud.height);
+    if(_unknown == 0) return;
+    for(std::size_t i = 0; i < _rayX.size(); ++i)
+    {
+        const PointType &p = cloud.points[i];
+        if(pcl::isFinite(p)) learn(i, p.x, p.y, p.z);
+    }
+}
+
+template <class PointType>
+bool 
+nimbus::DepthFrame::fromCloud(const pcl::PointCloud<PointType> &cloud, const RayTable::ConstPtr &rays, float scale)
+{
+    if(!rays || !rays->matches(cloud.width, cloud.height) || 
+       static_cast<std::size_t>(cloud.width) * cloud.height != cloud.points.size()) return false;
+    reset(cloud.width, cloud.height, rays, scale);
+    header = cloud.header;
+    const float maxAmplitude = std::numeric_limits<std::uint16_t>::max();
+    for(std::size_t i = 0; i < _depth.size(); ++i)
+    {
+        const PointType &p = cloud.points[i];
+        if(!pcl::isFinite(p) || !rays->known(i)) continue;
+        _depth[i] = quantize(p.z);
+        const float a = pointAmplitude(p);
+        _amplitude[i] = (a > 0) ? static_cast<std::uint16_t>(std::min(a + 0.5f, maxAmplitude)) : 0;
+    }
+    return true;
+}
+
+template <class PointType>
+void 
+nimbus::DepthFrame::toCloud(pcl::PointCloud<PointType> &res) const
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    res.header = header;
+    res.width = _width;
+    res.height = _height;
+    res.is_dense = false;
+    res.points.resize(_depth.size());
+    for(std::size_t i = 0; i < _depth.size(); ++i)
+    {
+        PointType &p = res.points[i];
+        if(isValid(i))
+        {
+            const Eigen::Vector3f xyz = point(i);
+            p.x = xyz[0];
+            p.y = xyz[1];
+            p.z = xyz[2];
+            setPointAmplitude(p, amplitude(i));
+        }else{
+            p.x = p.y = p.z = nan;
+            setPointAmplitude(p, nan);
+        }
+    }
+}
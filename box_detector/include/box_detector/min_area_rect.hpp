@@ -0,0 +1,62 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file min_area_rect.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <vector>
+#include <Eigen/Core>
+
+namespace nimbus
+{
+    /**
+     * @brief Oriented rectangle in a 2D plane
+     * length is the longer side, yaw is the angle of the length side w.r.t. the x axis
+     */
+    struct RotatedRect
+    {
+        Eigen::Vector2f center;
+        float length;
+        float width;
+        float yaw;
+        float area;
+    };
+
+    /**
+     * @brief Convex hull with Andrew's monotone chain, O(n log n)
+     * @param points Input points (copied, they get sorted)
+     * @param hull Counter clockwise hull without collinear points
+     */
+    void convexHull(std::vector<Eigen::Vector2f> points, std::vector<Eigen::Vector2f> &hull);
+
+    /**
+     * @brief Minimum area enclosing rectangle with rotating calipers, O(n) on the hull.
+     * One side of the optimal rectangle is collinear with a hull edge.
+     * @param hull Counter clockwise convex hull from convexHull
+     * @param rect Resulting rectangle
+     * @return false if the hull has less than three points
+     */
+    bool minAreaRect(const std::vector<Eigen::Vector2f> &hull, RotatedRect &rect);
+} // namespace nimbus
@@ -0,0 +1,97 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file robust_plane.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <random>
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+
+#include <box_detector/bitmask.hpp>
+#include <box_detector/soa_frame.hpp>
+
+enum class PlaneEstimator: unsigned char{
+    RANSAC = 0,     // Most inliers within the threshold
+    LMEDS = 1,      // Least median of squared distances, no threshold needed for the search
+};
+
+namespace nimbus
+{
+    /**
+     * @brief Robust plane of the masked pixels of a frame. Minimal samples of three points are
+     * scored on compact x, y, z arrays (vectorized by Eigen), the number of RANSAC iterations
+     * adapts to the best inlier ratio seen so far. The winner is refit by least squares on its inliers.
+     */
+    class RobustPlane
+    {
+        private:
+            typedef Eigen::Array<float, Eigen::Dynamic, 1> Array;
+            float _threshold;
+            float _confidence;
+            int _maxIterations;
+            std::size_t _maxPoints;
+            unsigned int _seed;
+            PlaneEstimator _estimator;
+            Array _x, _y, _z, _residual;
+            std::vector<float> _sorted;
+            std::mt19937 _random;
+            int _iterations;
+            std::size_t _inliers;
+            /** Plane through three points, false if they are (nearly) collinear */
+            bool samplePlane(Eigen::Vector4f &plane);
+            /** Least squares refit on the points within threshold of plane */
+            bool refit(float threshold, Eigen::Vector4f &plane, float &curvature);
+        public:
+            /**
+             * @param threshold Inlier distance in meter (RANSAC search and final refit)
+             * @param confidence Probability of drawing at least one outlier free sample
+             * @param maxIterations Upper bound of samples
+             * @param maxPoints Points used for scoring, larger masks are subsampled evenly (0: all)
+             * @param seed Seed of the sampler, every fit starts from it so results are reproducible
+             * @param estimator RANSAC or LMedS scoring
+             */
+            RobustPlane(float threshold = 0.005f, float confidence = 0.99f, int maxIterations = 200,
+                        std::size_t maxPoints = 4096, unsigned int seed = 42,
+                        PlaneEstimator estimator = PlaneEstimator::RANSAC);
+            ~RobustPlane();
+            void setParameter(float threshold, float confidence, int maxIterations,
+                              std::size_t maxPoints, PlaneEstimator estimator);
+            /**
+             * @brief Fit the plane of the valid pixels of frame that are set in mask
+             * @param plane Result a, b, c, d (ax + by + cz + d = 0), normal towards the camera
+             * @param curvature Surface curvature of the inliers, lambda_0 / (lambda_0 + lambda_1 + lambda_2)
+             * @return false with less than three points or no valid sample
+             */
+            bool fit(const SoAFrame &frame, const Bitmask &mask, Eigen::Vector4f &plane, float &curvature);
+            /** Inlier distance in meter */
+            float threshold() const { return _threshold; }
+            /** Samples drawn by the last fit */
+            int iterations() const { return _iterations; }
+            /** Inliers of the final plane among the scored points */
+            std::size_t inliers() const { return _inliers; }
+    };
+}
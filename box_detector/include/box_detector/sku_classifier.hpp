@@ -0,0 +1,91 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file sku_classifier.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+
+namespace nimbus
+{
+    /** Nominal dimensions of one box type in meter */
+    struct Sku
+    {
+        std::string name;
+        float length;
+        float width;
+        float height;           // 0: not compared
+        float tolerance;        // Allowed deviation of every dimension
+    };
+
+    struct SkuMatch
+    {
+        int index;              // Best SKU, -1 if no SKU is within tolerance
+        float distance;         // Largest dimension error of the best SKU in tolerances
+        float gap;              // Distance of the second best SKU minus distance, infinity without one
+        bool ambiguous;         // Another SKU fits nearly as well, ask the descriptor recognition
+    };
+
+    /**
+     * @brief Matches measured cuboid dimensions against a table of SKUs. Length and width
+     * are compared orientation free, the height only if measured and known for the SKU.
+     * A linear scan over a few entries, cheap enough to classify every blob of every frame.
+     */
+    class SkuClassifier
+    {
+        private:
+            std::vector<Sku> _skus;
+            float _margin;
+        public:
+            /**
+             * @param margin Two SKUs within tolerance whose distances differ by less than
+             * margin (in tolerances) are ambiguous
+             */
+            SkuClassifier(float margin = 0.5f);
+            ~SkuClassifier();
+            void setMargin(float margin){ _margin = margin; }
+            /** Adds the SKU, false without a positive tolerance */
+            bool add(const Sku &sku);
+            void clear(){ _skus.clear(); }
+            bool empty() const { return _skus.empty(); }
+            std::size_t size() const { return _skus.size(); }
+            const Sku &operator[](std::size_t i) const { return _skus[i]; }
+            /**
+             * @brief Best SKU of the measured dimensions
+             * @param length Measured length (order of length and width does not matter)
+             * @param width Measured width
+             * @param height Measured height, NaN if unknown
+             */
+            SkuMatch classify(float length, float width, float height) const;
+            /**
+             * @brief Match confidence in [0, 1]: 1 for an exact fit, falling linearly to 0 at the
+             * tolerance and scaled down by gap / margin for an ambiguous match, 0 without a match
+             */
+            float score(const SkuMatch &match) const;
+            /** Name of the match, "unknown" or "ambiguous" */
+            std::string name(const SkuMatch &match) const;
+    };
+}
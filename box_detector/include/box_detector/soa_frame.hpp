@@ -0,0 +1,210 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file soa_frame.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <Eigen/StdVector>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/common.h>
+
+#include <box_detector/bitmask.hpp>
+#include <box_detector/depth_frame.hpp>
+#include <nimbus_common/parallel.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief First and second order sums of points, shifted by a common origin for numerical
+     * stability. Partial sums of row bands with the same origin are merged with +=.
+     */
+    struct PointMoments
+    {
+        float ox, oy, oz;
+        double n, sx, sy, sz, sxx, sxy, sxz, syy, syz, szz;
+        PointMoments(float ox = 0, float oy = 0, float oz = 0):
+            ox(ox), oy(oy), oz(oz), n(0), sx(0), sy(0), sz(0), sxx(0), sxy(0), sxz(0), syy(0), syz(0), szz(0){}
+        void add(float x, float y, float z)
+        {
+            const double dx = x - ox, dy = y - oy, dz = z - oz;
+            sx += dx; sy += dy; sz += dz;
+            sxx += dx * dx; sxy += dx * dy; sxz += dx * dz;
+            syy += dy * dy; syz += dy * dz; szz += dz * dz;
+            n += 1;
+        }
+        void operator+=(const PointMoments &o)
+        {
+            n += o.n; sx += o.sx; sy += o.sy; sz += o.sz;
+            sxx += o.sxx; sxy += o.sxy; sxz += o.sxz;
+            syy += o.syy; syz += o.syz; szz += o.szz;
+        }
+        /** Centroid (x, y, z, 1) and covariance, false without points */
+        bool get(Eigen::Vector4f &centroid, Eigen::Matrix3f &covariance) const
+        {
+            covariance.setZero();
+            if(n == 0)
+            {
+                centroid.setConstant(std::numeric_limits<float>::quiet_NaN());
+                return false;
+            }
+            const double mx = sx / n, my = sy / n, mz = sz / n;
+            centroid << static_cast<float>(ox + mx), static_cast<float>(oy + my), static_cast<float>(oz + mz), 1.0f;
+            covariance(0, 0) = static_cast<float>(sxx / n - mx * mx);
+            covariance(0, 1) = covariance(1, 0) = static_cast<float>(sxy / n - mx * my);
+            covariance(0, 2) = covariance(2, 0) = static_cast<float>(sxz / n - mx * mz);
+            covariance(1, 1) = static_cast<float>(syy / n - my * my);
+            covariance(1, 2) = covariance(2, 1) = static_cast<float>(syz / n - my * mz);
+            covariance(2, 2) = static_cast<float>(szz / n - mz * mz);
+            return true;
+        }
+    };
+
+    /**
+     * @brief Organized frame as structure of arrays: separate aligned x, y, z and intensity planes
+     * plus a validity bitmask. The per pixel stages (cropping, z limits, background subtraction,
+     * statistics) stream over the planes in row bands, see RowBands. Invalid pixels keep whatever
+     * value they had, only the mask counts. Conversion to PCL points happens only at the boundary.
+     */
+    class SoAFrame
+    {
+        public:
+            typedef std::vector<float, Eigen::aligned_allocator<float> > Plane;
+            Plane x, y, z, intensity;
+            Bitmask valid;
+            pcl::PCLHeader header;
+        private:
+            int _width, _height;
+        public:
+            SoAFrame();
+            ~SoAFrame();
+            /** Planes of the given size, all pixels invalid */
+            void reset(int width, int height);
+            int width() const { return _width; }
+            int height() const { return _height; }
+            std::size_t size() const { return x.size(); }
+            template <class PointType>
+            void fromCloud(const pcl::PointCloud<PointType> &cloud);
+            /**
+             * @param res Result
+             * @param organized Keep the layout with NaN for invalid pixels, otherwise only the valid points
+             */
+            template <class PointType>
+            void toCloud(pcl::PointCloud<PointType> &res, bool organized = true) const;
+            /** Reconstruct the planes of a depth frame */
+            void fromDepthFrame(const DepthFrame &frame);
+            /**
+             * @brief Quantize into a depth frame and learn unknown rays on the way
+             * @param rays Ray table of the sensor, reset if the layout changed
+             * @param res Result
+             * @return false without a ray table
+             */
+            bool toDepthFrame(const RayTable::Ptr &rays, DepthFrame &res) const;
+            /**
+             * @brief Organized crop of the center window, same window as BoxDetector::outlineRemover
+             * @param perW Part of the width removed on both sides together
+             * @param perH Part of the height removed on both sides together
+             * @param res Cropped frame
+             * @param config Row band split
+             */
+            void crop(float perW, float perH, SoAFrame &res, const RowBands &config = RowBands()) const;
+            /** Invalidate pixels with z outside [min, max] */
+            void limitZ(float min, float max, const RowBands &config = RowBands());
+            /**
+             * @brief Keep only pixels that are more than tolerance in front of or behind the ground
+             * @param ground Frame of the empty scene with the same layout
+             * @param tolerance Depth difference in meter
+             * @param config Row band split
+             * @return false if the layouts differ
+             */
+            bool subtractBackground(const SoAFrame &ground, float tolerance, const RowBands &config = RowBands());
+            /**
+             * @brief Centroid and covariance of the valid pixels that are also set in mask
+             * @param mask Pixel selection, same layout
+             * @param centroid Result (x, y, z, 1), NaN if there is no point
+             * @param covariance Result
+             * @param config Row band split, per band sums are merged in band order
+             * @return Number of points
+             */
+            unsigned int meanAndCovariance(const Bitmask &mask, Eigen::Vector4f &centroid, Eigen::Matrix3f &covariance,
+                                           const RowBands &config = RowBands()) const;
+            /** Same over all valid pixels */
+            unsigned int meanAndCovariance(Eigen::Vector4f &centroid, Eigen::Matrix3f &covariance,
+                                           const RowBands &config = RowBands()) const
+            {
+                return meanAndCovariance(valid, centroid, covariance, config);
+            }
+    };
+}
+
+template <class PointType>
+void 
+nimbus::SoAFrame::fromCloud(const pcl::PointCloud<PointType> &cloud)
+{
+    const int height = cloud.height > 0 ? cloud.height : 1;
+    reset(static_cast<int>(cloud.points.size()) / height, height);
+    header = cloud.header;
+    for(std::size_t i = 0; i < cloud.points.size(); ++i)
+    {
+        const PointType &p = cloud.points[i];
+        x[i] = p.x;
+        y[i] = p.y;
+        z[i] = p.z;
+        intensity[i] = pointAmplitude(p);
+        valid.assign(i, pcl::isFinite(p));
+    }
+}
+
+template <class PointType>
+void 
+nimbus::SoAFrame::toCloud(pcl::PointCloud<PointType> &res, bool organized) const
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    res.header = header;
+    res.is_dense = !organized;
+    res.points.clear();
+    res.points.reserve(organized ? size() : valid.count());
+    for(std::size_t i = 0; i < size(); ++i)
+    {
+        PointType p;
+        if(valid.test(i))
+        {
+            p.x = x[i];
+            p.y = y[i];
+            p.z = z[i];
+            setPointAmplitude(p, intensity[i]);
+        }else if(organized){
+            p.x = p.y = p.z = nan;
+            setPointAmplitude(p, nan);
+        }else continue;
+        res.points.push_back(p);
+    }
+    res.width = organized ? _width : static_cast<std::uint32_t>(res.points.size());
+    res.height = organized ? _height : 1;
+}
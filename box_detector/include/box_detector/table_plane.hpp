@@ -0,0 +1,102 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file table_plane.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <vector>
+#include <Eigen/Dense>
+
+#include <box_detector/bitmask.hpp>
+#include <nimbus_common/parallel.hpp>
+#include <box_detector/soa_frame.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Dominant table plane of an organized frame, replaces the captured empty table.
+     * Cold start: the frame is tiled into cells, planar cells (small RMS plane distance) are joined into
+     * connected components when their normals and offsets agree, and the largest component is
+     * refined with its inliers. Later frames start from the previous plane: its inliers are refit
+     * and the result is accepted if it still supports enough of the frame.
+     */
+    class TablePlane
+    {
+        private:
+            float _margin;
+            float _inlierDistance;
+            int _cellSize;
+            float _maxCellRms;
+            float _maxAngle;
+            float _minSupport;
+            Eigen::Vector4f _plane;     // n.p + d = 0, n points towards the camera
+            bool _valid;
+            bool _warm;
+            unsigned int _inliers;
+            std::vector<int> _parent;
+            /** Least squares plane of the valid pixels within the inlier distance of plane */
+            bool refit(const SoAFrame &frame, const Eigen::Vector4f &plane, const RowBands &config,
+                       Eigen::Vector4f &res, unsigned int &inliers) const;
+            bool segment(const SoAFrame &frame, const RowBands &config, Eigen::Vector4f &res);
+            int find(int i);
+        public:
+            /**
+             * @param margin Minimum height above the plane of the foreground in meter
+             * @param inlierDistance Maximum distance of a table point from the plane in meter
+             * @param cellSize Cell edge in pixel of the cold start segmentation
+             * @param maxCellRms Maximum RMS distance of the points of a planar cell from its plane in meter
+             * @param maxAngle Maximum normal angle between joined cells and between frames in radian
+             * @param minSupport Part of the valid pixels the warm started plane has to support
+             */
+            TablePlane(float margin = 0.02f, float inlierDistance = 0.01f, int cellSize = 8,
+                       float maxCellRms = 0.005f, float maxAngle = 0.1745f, float minSupport = 0.3f);
+            ~TablePlane();
+            void setParameter(float margin, float inlierDistance, int cellSize,
+                              float maxCellRms, float maxAngle, float minSupport);
+            void setMargin(float margin){ _margin = margin; }
+            /** Forget the previous plane, the next frame is segmented from scratch */
+            void reset(){ _valid = false; }
+            /**
+             * @brief Fit the table plane of the frame
+             * @param frame Organized frame in the camera frame
+             * @param config Row band split
+             * @return false if no plane with enough support was found
+             */
+            bool fit(const SoAFrame &frame, const RowBands &config = RowBands());
+            /**
+             * @brief Fit and mark the valid pixels more than margin above the plane
+             * @param frame Organized frame in the camera frame
+             * @param mask Foreground pixels
+             * @param config Row band split
+             * @return false if there is no table plane, the mask is empty then
+             */
+            bool foreground(const SoAFrame &frame, Bitmask &mask, const RowBands &config = RowBands());
+            const Eigen::Vector4f &plane() const { return _plane; }
+            bool valid() const { return _valid; }
+            /** The last fit was warm started from the previous plane */
+            bool warmStarted() const { return _warm; }
+            unsigned int inliers() const { return _inliers; }
+    };
+}
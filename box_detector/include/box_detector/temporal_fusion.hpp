@@ -0,0 +1,283 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file temporal_fusion.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/common.h>
+
+#include <box_detector/depth_frame.hpp>
+#include <nimbus_common/parallel.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Per pixel fusion of a short window of organized frames, weighted by the amplitude.
+     * The depth noise of the time of flight sensor falls with the amplitude, so a sample gets the
+     * confidence c = min(1, amplitude / full_amplitude) and the weight c^2 (inverse variance).
+     * Samples further than outlier_scale * 1.4826 * MAD from the per pixel median depth
+     * (at least outlier_scale * min_sigma) are rejected, missing samples are simply skipped.
+     * @tparam PointType Point type with an intensity field (amplitude)
+     */
+    template <class PointType>
+    class ConfidenceFusion
+    {
+        private:
+            float _minAmplitude;
+            float _fullAmplitude;
+            float _outlierScale;
+            float _minSigma;
+            unsigned int _threads;
+            struct Sample
+            {
+                float x, y, z, amplitude;
+            };
+            /**
+             * @brief Robust amplitude weighted mean of the samples of one pixel
+             * @param samples Valid samples, reordered
+             * @param scratch Reused buffer
+             * @param out Fused sample
+             * @param conf Sum of the inlier confidences
+             */
+            void fusePixel(std::vector<Sample> &samples, std::vector<float> &scratch, Sample &out, float &conf) const;
+        public:
+            typedef boost::shared_ptr<const pcl::PointCloud<PointType>> CloudConstPtr;
+            /**
+             * @param min_amplitude Samples below are ignored
+             * @param full_amplitude Amplitude of full confidence
+             * @param outlier_scale Rejection threshold in robust standard deviations
+             * @param min_sigma Lower bound of the robust standard deviation in meter
+             * @param threads Worker threads, 0 selects the hardware concurrency 
+             */
+            ConfidenceFusion(float min_amplitude = 0.0f, float full_amplitude = 1000.0f, 
+                             float outlier_scale = 3.0f, float min_sigma = 0.002f, unsigned int threads = 0);
+            ~ConfidenceFusion();
+            void setParameter(float min_amplitude, float full_amplitude, float outlier_scale, float min_sigma);
+            void setThreads(unsigned int threads){ _threads = threads; }
+            /**
+             * @brief Fuse the frames, frames of a different size than the first one are skipped
+             * @param frames Organized frames of the same sensor
+             * @param res Fused cloud with the layout of the first frame, NaN where no sample survived
+             * @param confidence Per pixel confidence in [0, 1]: sum of the inlier sample confidences over the number of fused frames
+             * @return false if there is no frame
+             */
+            bool fuse(const std::vector<CloudConstPtr> &frames, pcl::PointCloud<PointType> &res, std::vector<float> &confidence);
+            /**
+             * @brief Same fusion on compact depth frames, XYZ is only reconstructed for the result
+             * @param frames Depth frames of the same layout as the first one, others are skipped
+             * @param res Fused organized cloud
+             * @param confidence Per pixel confidence in [0, 1]
+             * @return false if there is no frame
+             */
+            bool fuse(const std::vector<DepthFrame> &frames, pcl::PointCloud<PointType> &res, std::vector<float> &confidence);
+    };
+}
+
+template <class PointType>
+nimbus::ConfidenceFusion<PointType>::ConfidenceFusion(float min_amplitude, float full_amplitude, 
+                                                      float outlier_scale, float min_sigma, unsigned int threads): _threads(threads)
+{
+    setParameter(min_amplitude, full_amplitude, outlier_scale, min_sigma);
+}
+template <class PointType>
+nimbus::ConfidenceFusion<PointType>::~ConfidenceFusion(){}
+
+template <class PointType>
+void 
+nimbus::ConfidenceFusion<PointType>::setParameter(float min_amplitude, float full_amplitude, float outlier_scale, float min_sigma)
+{
+    _minAmplitude = min_amplitude;
+    _fullAmplitude = full_amplitude > 0 ? full_amplitude : 1.0f;
+    _outlierScale = outlier_scale;
+    _minSigma = min_sigma;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+void 
+nimbus::ConfidenceFusion<PointType>::fusePixel(std::vector<Sample> &samples, std::vector<float> &scratch, 
+                                               Sample &out, float &conf) const
+{
+    // Median and median absolute deviation of the depth
+    const std::size_t mid = samples.size() / 2;
+    scratch.clear();
+    for(const auto &sample: samples) scratch.push_back(sample.z);
+    std::nth_element(scratch.begin(), scratch.begin() + mid, scratch.end());
+    const float median = scratch[mid];
+    for(std::size_t k = 0; k < samples.size(); ++k) scratch[k] = std::abs(samples[k].z - median);
+    std::nth_element(scratch.begin(), scratch.begin() + mid, scratch.end());
+    const float sigma = std::max(1.4826f * scratch[mid], _minSigma);
+    const float gate = _outlierScale * sigma;
+
+    double x = 0, y = 0, z = 0, a = 0, weight = 0;
+    conf = 0;
+    for(const auto &sample: samples)
+    {
+        if(std::abs(sample.z - median) > gate) continue;
+        const float c = std::min(1.0f, sample.amplitude / _fullAmplitude);
+        // Keep a floor so zero amplitude samples still count when nothing better is there
+        const double w = std::max(c * c, 1e-6f);
+        x += w * sample.x;
+        y += w * sample.y;
+        z += w * sample.z;
+        a += w * sample.amplitude;
+        weight += w;
+        conf += c;
+    }
+    // The median sample is always an inlier, weight is never zero
+    out.x = static_cast<float>(x / weight);
+    out.y = static_cast<float>(y / weight);
+    out.z = static_cast<float>(z / weight);
+    out.amplitude = static_cast<float>(a / weight);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+bool 
+nimbus::ConfidenceFusion<PointType>::fuse(const std::vector<CloudConstPtr> &frames, pcl::PointCloud<PointType> &res, 
+                                          std::vector<float> &confidence)
+{
+    if(frames.empty() || !frames.front()) return false;
+    const pcl::PointCloud<PointType> &first = *frames.front();
+    const std::size_t size = first.points.size();
+    std::vector<const pcl::PointCloud<PointType>*> window;
+    for(const auto &frame: frames)
+        if(frame && frame->points.size() == size) window.push_back(frame.get());
+    // Skipped frames of another layout do not lower the confidence
+    const float frameCount = static_cast<float>(window.size());
+
+    res.header = frames.back()->header;
+    res.width = first.width;
+    res.height = first.height;
+    res.is_dense = false;
+    res.points.resize(size);
+    confidence.assign(size, 0.0f);
+
+    const std::size_t rows = first.height > 0 ? first.height : 1;
+    const std::size_t cols = size / rows;
+    parallelFor(rows, hardwareThreads(_threads), [&](std::size_t begin, std::size_t end, unsigned int){
+        std::vector<Sample> samples;
+        std::vector<float> scratch;
+        samples.reserve(window.size());
+        scratch.reserve(window.size());
+        const std::size_t last = (end == rows) ? size : end * cols;
+        for(std::size_t i = begin * cols; i < last; ++i)
+        {
+            PointType &out = res.points[i];
+            out = first.points[i];
+            samples.clear();
+            for(const auto *frame: window)
+            {
+                const PointType &p = frame->points[i];
+                // NaN amplitude fails the comparison as well
+                if(pcl::isFinite(p) && pointAmplitude(p) >= _minAmplitude)
+                    samples.push_back(Sample{p.x, p.y, p.z, pointAmplitude(p)});
+            }
+            if(samples.empty())
+            {
+                out.x = out.y = out.z = std::numeric_limits<float>::quiet_NaN();
+                setPointAmplitude(out, std::numeric_limits<float>::quiet_NaN());
+                continue;
+            }
+            Sample fused;
+            float conf;
+            fusePixel(samples, scratch, fused, conf);
+            out.x = fused.x;
+            out.y = fused.y;
+            out.z = fused.z;
+            setPointAmplitude(out, fused.amplitude);
+            confidence[i] = conf / frameCount;
+        }
+    });
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+bool 
+nimbus::ConfidenceFusion<PointType>::fuse(const std::vector<DepthFrame> &frames, pcl::PointCloud<PointType> &res, 
+                                          std::vector<float> &confidence)
+{
+    if(frames.empty() || !frames.front().rays()) return false;
+    const DepthFrame &first = frames.front();
+    const std::size_t size = first.size();
+    std::vector<const DepthFrame*> window;
+    for(const auto &frame: frames)
+        if(frame.width() == first.width() && frame.size() == size) window.push_back(&frame);
+    // Skipped frames of another layout do not lower the confidence
+    const float frameCount = static_cast<float>(window.size());
+    const RayTable &rays = *first.rays();
+
+    res.header = frames.back().header;
+    res.width = first.width();
+    res.height = first.height();
+    res.is_dense = false;
+    res.points.resize(size);
+    confidence.assign(size, 0.0f);
+
+    const std::size_t rows = first.height() > 0 ? first.height() : 1;
+    const std::size_t cols = size / rows;
+    parallelFor(rows, hardwareThreads(_threads), [&](std::size_t begin, std::size_t end, unsigned int){
+        std::vector<Sample> samples;
+        std::vector<float> scratch;
+        samples.reserve(window.size());
+        scratch.reserve(window.size());
+        const std::size_t last = (end == rows) ? size : end * cols;
+        for(std::size_t i = begin * cols; i < last; ++i)
+        {
+            PointType &out = res.points[i];
+            samples.clear();
+            for(const auto *frame: window)
+            {
+                if(frame->isValid(i) && frame->amplitude(i) >= _minAmplitude)
+                    samples.push_back(Sample{0.0f, 0.0f, frame->depth(i), frame->amplitude(i)});
+            }
+            if(samples.empty())
+            {
+                out.x = out.y = out.z = std::numeric_limits<float>::quiet_NaN();
+                setPointAmplitude(out, std::numeric_limits<float>::quiet_NaN());
+                continue;
+            }
+            Sample fused;
+            float conf;
+            fusePixel(samples, scratch, fused, conf);
+            // Fixed ray per pixel, only the depth has to be fused
+            out.x = fused.z * rays.rayX(i);
+            out.y = fused.z * rays.rayY(i);
+            out.z = fused.z;
+            setPointAmplitude(out, fused.amplitude);
+            confidence[i] = conf / frameCount;
+        }
+    });
+    return true;
+}
@@ -0,0 +1,124 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file workspace_roi.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Geometry>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/common.h>
+
+#include <box_detector/depth_frame.hpp>
+#include <box_detector/soa_frame.hpp>
+#include <nimbus_common/parallel.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Workspace as oriented box in the robot base frame, projected once into the sensor:
+     * a tight pixel window plus per pixel depth bounds where the pixel ray enters and leaves
+     * the box. Only needs to be updated when the camera extrinsics change, cropping then only
+     * visits the pixels of the window.
+     */
+    class WorkspaceROI
+    {
+        private:
+            Eigen::Isometry3f _pose;        // Box center in the base frame
+            Eigen::Vector3f _halfSize;
+            int _sensorWidth, _sensorHeight;
+            int _rowBegin, _rowEnd, _colBegin, _colEnd;
+            std::vector<float> _near, _far;  // Depth bounds of the window pixels, NaN if the ray misses
+        public:
+            typedef boost::shared_ptr<WorkspaceROI> Ptr;
+            WorkspaceROI();
+            ~WorkspaceROI();
+            /**
+             * @brief Workspace box
+             * @param pose Pose of the box center in the robot base frame
+             * @param size Edge lengths along the box axes
+             */
+            void setBox(const Eigen::Isometry3f &pose, const Eigen::Vector3f &size);
+            /**
+             * @brief Project the box into the sensor
+             * @param baseToCamera Transformation of base frame coordinates into the camera frame
+             * @param rays Ray table of the full sensor frame. Pixels without a known ray inside
+             *             the window get the depth range of the whole box.
+             * @return false if no pixel sees the box
+             */
+            bool update(const Eigen::Isometry3f &baseToCamera, const RayTable &rays);
+            /** Projected and the sensor layout did not change */
+            bool valid(int width, int height) const
+            {
+                return !_near.empty() && width == _sensorWidth && height == _sensorHeight;
+            }
+            int windowWidth() const { return _colEnd - _colBegin; }
+            int windowHeight() const { return _rowEnd - _rowBegin; }
+            int rowBegin() const { return _rowBegin; }
+            int colBegin() const { return _colBegin; }
+            float nearDepth(int row, int col) const { return _near[row * windowWidth() + col]; }
+            float farDepth(int row, int col) const { return _far[row * windowWidth() + col]; }
+            /**
+             * @brief Organized crop to the window, points outside the depth bounds are invalid
+             * @param cloud Full sensor cloud, see valid()
+             * @param res Window frame
+             * @param config Row band split
+             */
+            template <class PointType>
+            void crop(const pcl::PointCloud<PointType> &cloud, SoAFrame &res, const RowBands &config = RowBands()) const;
+    };
+}
+
+template <class PointType>
+void 
+nimbus::WorkspaceROI::crop(const pcl::PointCloud<PointType> &cloud, SoAFrame &res, const RowBands &config) const
+{
+    const int cols = windowWidth();
+    res.reset(cols, windowHeight());
+    res.header = cloud.header;
+    std::vector<unsigned char> inside(res.size(), 0);
+    parallelRows(windowHeight(), cols, config, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t r = begin; r < end; ++r)
+        {
+            const std::size_t src = (r + _rowBegin) * _sensorWidth + _colBegin;
+            for(int c = 0; c < cols; ++c)
+            {
+                const PointType &p = cloud.points[src + c];
+                const std::size_t i = r * cols + c;
+                res.x[i] = p.x;
+                res.y[i] = p.y;
+                res.z[i] = p.z;
+                res.intensity[i] = pointAmplitude(p);
+                inside[i] = pcl::isFinite(p) && p.z >= _near[i] && p.z <= _far[i];
+            }
+        }
+    });
+    // Bits of neighbouring rows share words, the mask is packed in one pass
+    for(std::size_t i = 0; i < inside.size(); ++i)
+        if(inside[i]) res.valid.set(i);
+}
@@ -25,28 +25,16 @@
  * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
  */
 
-#include <ros/ros.h>
-#include <visualization_msgs/Marker.h>
-#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
-#include <tf2/LinearMath/Matrix3x3.h>
+#include <algorithm>
 #include <pcl/common/eigen.h>
+#include <pcl/common/io.h>
 #include <box_detector/box_detector.hpp>
+#include <box_detector/min_area_rect.hpp>
 
 template class nimbus::BoxDetector<pcl::PointXYZ>;
 
 template <class PointType>
-nimbus::BoxDetector<PointType>::BoxDetector(ros::NodeHandle nh): _nh(nh){
-    _pub_marker = _nh.advertise<visualization_msgs::Marker> ("bounding_box", 1);
-    _marker.header.frame_id = "camera";
-    _marker.ns = "basic_shapes";
-    _marker.id = 0;
-    _marker.type = _shape;
-    _marker.action = visualization_msgs::Marker::ADD;
-    _marker.color.r = 0.0f;
-    _marker.color.g = 1.0f;
-    _marker.color.b = 0.0f;
-    _marker.color.a = 1.0;
-
+nimbus::BoxDetector<PointType>::BoxDetector(){
     cornerBuffer.setZero();
     cornerBufferCounter = 0;
 }
@@ -61,33 +49,44 @@ nimbus::BoxDetector<PointType>::zAxisLimiter(const boost::shared_ptr<const pcl::
                                              double max, double min,
                                              pcl::PointCloud<pcl::PointXYZ> &res)
 {
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>());
-    pcl::PointCloud<pcl::PointXYZ>::Ptr result (new pcl::PointCloud<pcl::PointXYZ>());
-    pcl::copyPointCloud(*blob, *cloud); 
-    // To Carry other info
-    pcl::copyPointCloud(*blob, *result);
-
     // Check the size of input points
-    if(cloud->points.empty())
-    {
-        ROS_ERROR("Input Point Cloud is empty");
+    if(blob->points.empty())
         return;
-    }
-
-    for (size_t i = 0; i < cloud->points.size(); ++i)
-    {
-        if((max >= cloud->points[i].z) && (min <= cloud->points[i].z))
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    // To Carry other info
+    pcl::PointCloud<pcl::PointXYZ> result;
+    result.header = blob->header;
+    result.width = blob->width;
+    result.height = blob->height;
+    result.is_dense = false;
+    result.sensor_orientation_ = blob->sensor_orientation_;
+    result.sensor_origin_ = blob->sensor_origin_;
+    result.points.resize(blob->points.size());
+    const std::size_t width = std::max<std::size_t>(blob->width, 1);
+    parallelRows(blob->points.size() / width, width, _bands, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t i = begin * width; i < end * width; ++i)
         {
-            pcl::copyPoint(cloud->points[i], result->points[i]);
-        }else{
-            result->points[i].x = NAN;
-            result->points[i].y = NAN;
-            result->points[i].y = NAN;
+            const pcl::PointXYZ &p = blob->points[i];
+            if((max >= p.z) && (min <= p.z))
+                result.points[i] = p;
+            else
+                result.points[i].x = result.points[i].y = result.points[i].z = nan;
         }
-    }
+    });
+    res.swap(result);
+}
 
-    // Copy to result
-    pcl::copyPointCloud(*result, res);
+template <class PointType>
+void 
+nimbus::BoxDetector<PointType>::zAxisLimiter(const SoAFrame &frame, double max, double min, Bitmask &mask)
+{
+    mask = frame.valid;
+    // Whole words per band, bits of one word never cross two threads
+    parallelRows(mask.words().size(), 64, _bands, [&](std::size_t begin, std::size_t end, unsigned int){
+        mask.forEach(begin, end, [&](std::size_t i){
+            if(!((max >= frame.z[i]) && (min <= frame.z[i]))) mask.clear(i);
+        });
+    });
 }
 
 template <class PointType>
@@ -99,37 +98,29 @@ void nimbus::BoxDetector<PointType>::outlineRemover(const boost::shared_ptr< con
     int hUpper = (height - hLower);
     int wLower = (width*perW)/2;
     int wUpper = width - wLower;
-    int pCounter = 0;
-    //res.width = width-wLower-wUpper;
-    //res.height = height-hLower-hUpper;
-    for(int i = 0; i < height; i++){
-        std::vector<float> tempX;
-        std::vector<float> tempY;
-        std::vector<float> tempZ;
-        for(int j = 0; j < width; j++){
-            if((i > hLower & i < hUpper) & (j > wLower & j < wUpper)){
-                tempX.push_back(blob->points[pCounter].x);
-                tempY.push_back(blob->points[pCounter].y);
-                tempZ.push_back(blob->points[pCounter].z);
-                pCounter ++;
-            }else pCounter ++;
-        }
-        if((i > hLower & i < hUpper)){
-            for(int i = 0; i < tempX.size(); i++){
-                PointType temP;
-                temP.x = tempX[i];
-                temP.y = tempY[i];
-                temP.z = tempZ[i];
-                res.points.push_back(temP);
+    // Keep the cropped window organized, the segmentation works on the pixel grid
+    int rows = std::max(hUpper - hLower - 1, 0);
+    int cols = std::max(wUpper - wLower - 1, 0);
+    res.points.resize(static_cast<std::size_t>(rows) * cols);
+    parallelRows(rows, cols, _bands, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t r = begin; r < end; ++r)
+        {
+            const std::size_t src = (r + hLower + 1) * width + wLower + 1;
+            for(int c = 0; c < cols; ++c)
+            {
+                PointType &temP = res.points[r * cols + c];
+                temP.x = blob->points[src + c].x;
+                temP.y = blob->points[src + c].y;
+                temP.z = blob->points[src + c].z;
             }
         }
-    }
+    });
     res.header   = blob->header;
     res.is_dense = blob->is_dense;
     res.sensor_orientation_ = blob->sensor_orientation_;
     res.sensor_origin_ = blob->sensor_origin_;
-    res.width = res.points.size();
-    res.height = 1;
+    res.width = cols;
+    res.height = rows;
 }
 
 template <class PointType>
@@ -141,37 +132,33 @@ nimbus::BoxDetector<PointType>::getBaseModel(const boost::shared_ptr<const pcl::
                                  pcl::PointCloud<pcl::PointXYZ> &res)
 {
     if(groud->points.size() != raw->points.size()){
-        ROS_ERROR ("Size of ground truth and raw point cloud is not matching");
-        ROS_WARN ("Deleting the current file");
+        // Ground truth does not belong to this sensor setup, force a new capture
         boost::filesystem::remove(path);
         return false;
     }
-    typename pcl::PointCloud<pcl::PointXYZ>::Ptr edit_cloud (new pcl::PointCloud<pcl::PointXYZ>());
-    // Store the difference of z axis values;
-    std::vector<float> absZ;
-    for (int i = 0; i < groud->points.size(); i ++){
-        if(!std::isnan(groud->points[i].z) && !std::isnan(raw->points[i].z))
-            absZ.push_back(std::abs(groud->points[i].z - raw->points[i].z));
-        else
-            absZ.push_back(NAN);
-    }
-    
-    for (int i = 0; i < absZ.size(); i ++){
-        pcl::PointXYZ temp;
-        if(!std::isnan(absZ[i]) && absZ[i] > tolerence)
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    pcl::PointCloud<pcl::PointXYZ> edit_cloud;
+    edit_cloud.points.resize(raw->points.size());
+    const std::size_t width = std::max<std::size_t>(raw->width, 1);
+    const std::size_t rows = (raw->points.size() + width - 1) / width;
+    parallelRows(rows, width, _bands, [&](std::size_t begin, std::size_t end, unsigned int){
+        end = std::min(end * width, raw->points.size());
+        for(std::size_t i = begin * width; i < end; ++i)
         {
-            temp.x = raw->points[i].x;
-            temp.y = raw->points[i].y;
-            temp.z = raw->points[i].z;
-        }
-        else{
-            temp.x = NAN;
-            temp.y = NAN;
-            temp.z = NAN;
+            // Difference of the z axis values
+            const float absZ = std::abs(groud->points[i].z - raw->points[i].z);
+            pcl::PointXYZ &temp = edit_cloud.points[i];
+            if(!std::isnan(absZ) && absZ > tolerence)
+            {
+                temp.x = raw->points[i].x;
+                temp.y = raw->points[i].y;
+                temp.z = raw->points[i].z;
+            }else{
+                temp.x = temp.y = temp.z = nan;
+            }
         }
-        edit_cloud->points.push_back(temp);
-    }
-    pcl::copyPointCloud(*edit_cloud, res);
+    });
+    res.points.swap(edit_cloud.points);
     res.header   = raw->header;
     res.is_dense = raw->is_dense;
     res.sensor_orientation_ = raw->sensor_orientation_;
@@ -181,6 +168,74 @@ nimbus::BoxDetector<PointType>::getBaseModel(const boost::shared_ptr<const pcl::
     return true;
 }
         
+template <class PointType>
+bool
+nimbus::BoxDetector<PointType>::getBaseModel(const DepthFrame &ground, const DepthFrame &raw, double tolerence,
+                                             pcl::PointCloud<pcl::PointXYZ> &res)
+{
+    if(ground.size() != raw.size() || ground.width() != raw.width() || ground.scale() != raw.scale()) return false;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    // Compare in quantization steps, no XYZ needed for the background
+    const std::uint16_t step = raw.quantize(static_cast<float>(tolerence));
+    res.header = raw.header;
+    res.width = raw.width();
+    res.height = raw.height();
+    res.is_dense = false;
+    res.points.resize(raw.size());
+    const std::size_t width = raw.width();
+    parallelRows(raw.height(), width, _bands, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t i = begin * width; i < end * width; ++i)
+        {
+            pcl::PointXYZ &p = res.points[i];
+            if(ground.isValid(i) && raw.isValid(i) &&
+               std::abs(static_cast<int>(ground.rawDepth(i)) - static_cast<int>(raw.rawDepth(i))) > step)
+            {
+                p.getVector3fMap() = raw.point(i);
+            }else{
+                p.x = p.y = p.z = nan;
+            }
+        }
+    });
+    return true;
+}
+
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::getBaseModel(const DepthFrame &ground, const DepthFrame &raw, double tolerence,
+                                             SoAFrame &res)
+{
+    if(ground.size() != raw.size() || ground.width() != raw.width() || ground.scale() != raw.scale()) return false;
+    res.fromDepthFrame(raw);
+    return getBaseModel(ground, raw, tolerence, res.valid);
+}
+
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::getBaseModel(const DepthFrame &ground, const DepthFrame &raw, double tolerence,
+                                             Bitmask &mask)
+{
+    if(ground.size() != raw.size() || ground.width() != raw.width() || ground.scale() != raw.scale()) return false;
+    const std::uint16_t step = raw.quantize(static_cast<float>(tolerence));
+    mask.reset(raw.width(), raw.height());
+    std::vector<std::uint64_t> &words = mask.words();
+    // Whole words per band, bits of one word never cross two threads
+    parallelRows(words.size(), 64, _bands, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t k = begin; k < end; ++k)
+        {
+            std::uint64_t word = 0;
+            const std::size_t last = std::min<std::size_t>((k + 1) << 6, raw.size());
+            for(std::size_t i = k << 6; i < last; ++i)
+            {
+                if(ground.isValid(i) && raw.isValid(i) &&
+                   std::abs(static_cast<int>(ground.rawDepth(i)) - static_cast<int>(raw.rawDepth(i))) > step)
+                    word |= std::uint64_t(1) << (i & 63);
+            }
+            words[k] = word;
+        }
+    });
+    return true;
+}
+
 template <class PointType>
 bool 
 nimbus::BoxDetector<PointType>::computePointNormal(const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob,
@@ -199,41 +254,55 @@ nimbus::BoxDetector<PointType>::computePointNormal(const boost::shared_ptr<const
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::computePointNormal(const SoAFrame &frame, const Bitmask &mask,
+                                                   Eigen::Vector4f &plane_parameters, float &curvature)
+{
+    return _robustPlane.fit(frame, mask, plane_parameters, curvature);
+}
+
 template <class PointType>
 void 
 nimbus::BoxDetector<PointType>::box3DCentroid(const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob,
                                               Eigen::Matrix<float, 4, 1> &centroid)
 {
-    pcl::PointCloud<pcl::PointXYZ> cloud;
-    pcl::copyPointCloud(*blob, cloud);
-    if(cloud.points.empty())
+    const pcl::PointCloud<pcl::PointXYZ> &cloud = *blob;
+    // Dense Cloud is Not Acceptable
+    if(cloud.points.empty() || cloud.is_dense)
     {
-        ROS_ERROR("Input Point Cloud is empty");
-        return;
-    }
-    if(cloud.is_dense)
-    {
-        ROS_ERROR_NAMED("Covariance Matrix", "!Dense Cloud is Not Acceptable!");
+        centroid.setConstant(std::numeric_limits<float>::quiet_NaN());
         return;
     }
 
-    // Initialize centroid to zero
-    centroid.setZero();
-    // Cloud Dense is false and contain NAN points
-    unsigned cp = 0;
-    for(const auto& point: cloud)
-    {
-        if(!pcl::isFinite(point))
-            continue;
-        
-        centroid[0] += point.x;
-        centroid[1] += point.y;
-        centroid[2] += point.z;
-        ++cp;
-    }
-    centroid /= static_cast<float>(cp);
+    // Cloud Dense is false and contain NAN points, per band sums merged in band order
+    typedef std::pair<Eigen::Vector3d, unsigned> Sum;
+    const std::size_t width = std::max<std::size_t>(cloud.width, 1);
+    const std::size_t rows = (cloud.points.size() + width - 1) / width;
+    const Sum sum = parallelReduceRows(rows, width, _bands, Sum(Eigen::Vector3d::Zero(), 0u),
+        [&](std::size_t begin, std::size_t end, Sum &band){
+            end = std::min(end * width, cloud.points.size());
+            for(std::size_t i = begin * width; i < end; ++i)
+            {
+                const pcl::PointXYZ &point = cloud.points[i];
+                if(!pcl::isFinite(point))
+                    continue;
+                band.first += point.getVector3fMap().cast<double>();
+                ++band.second;
+            }
+        },
+        [](Sum &total, const Sum &band){ total.first += band.first; total.second += band.second; });
+    centroid.head<3>() = (sum.first / static_cast<double>(sum.second)).cast<float>();
     centroid[3] = 1;
-    ROS_DEBUG_NAMED("Computed 3D Centroid","Calculated Points: %f", static_cast<float>(cp));
+}
+
+template <class PointType>
+void 
+nimbus::BoxDetector<PointType>::box3DCentroid(const SoAFrame &frame, const Bitmask &mask,
+                                              Eigen::Matrix<float, 4, 1> &centroid)
+{
+    Eigen::Matrix3f covariance;
+    frame.meanAndCovariance(mask, centroid, covariance, _bands);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -244,18 +313,10 @@ nimbus::BoxDetector<PointType>::boxCovarianceMatrix (const boost::shared_ptr<con
                                           const Eigen::Matrix<float, 4, 1> &centroid,
                                           Eigen::Matrix<float, 3, 3> &covariance_matrix)
 {
-    pcl::PointCloud<pcl::PointXYZ> cloud;
-    pcl::copyPointCloud(*blob, cloud);
-    if(cloud.points.empty())
-    {
-        ROS_ERROR("Input Point Cloud is empty");
-        return 0;
-    }
-    if(cloud.is_dense)
-    {
-        ROS_ERROR_NAMED("Covariance Matrix", "!Dense Cloud is Not Acceptable!");
+    const pcl::PointCloud<pcl::PointXYZ> &cloud = *blob;
+    // Dense Cloud is Not Acceptable
+    if(cloud.points.empty() || cloud.is_dense)
         return 0;
-    }
 
     // Initialize centroid to zero
     covariance_matrix.setZero();
@@ -285,7 +346,6 @@ nimbus::BoxDetector<PointType>::boxCovarianceMatrix (const boost::shared_ptr<con
     covariance_matrix (2, 0) = covariance_matrix (0, 2);
     covariance_matrix (2, 1) = covariance_matrix (1, 2);
 
-    ROS_DEBUG_NAMED("Computed Covariance Matrix","Calculated Points: %f", static_cast<float>(cp));
     return (cp);
 }
 
@@ -301,7 +361,6 @@ nimbus::BoxDetector<PointType>::boxCovarianceMatrixNormalized(const boost::share
     if(point_count != 0)
         covariance_matrix /= static_cast<float>(point_count);
     
-    ROS_DEBUG_NAMED("Computed Covariance Matrix Normalized","Calculated Points: %f", static_cast<float>(point_count));
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -312,18 +371,10 @@ nimbus::BoxDetector<PointType>::boxMeanAndCovarianceMatrix (const boost::shared_
                                                             Eigen::Matrix<float, 3, 3> &covariance_matrix,
                                                             Eigen::Matrix<float, 4, 1> &centroid)
 {
-    pcl::PointCloud<pcl::PointXYZ> cloud;
-    pcl::copyPointCloud(*blob, cloud);
-    if(cloud.points.empty())
-    {
-        ROS_ERROR("Input Point Cloud is empty");
+    const pcl::PointCloud<pcl::PointXYZ> &cloud = *blob;
+    // Dense Cloud is Not Acceptable
+    if(cloud.points.empty() || cloud.is_dense)
         return 0;
-    }
-    if(cloud.is_dense)
-    {
-        ROS_ERROR_NAMED("Covariance Matrix", "!Dense Cloud is Not Acceptable!");
-        return 0;
-    }
 
     Eigen::Matrix<float, 1, 9, Eigen::RowMajor> accu = Eigen::Matrix<float, 1, 9, Eigen::RowMajor>::Zero();
     std::size_t point_count = 0;
@@ -363,7 +414,6 @@ nimbus::BoxDetector<PointType>::boxMeanAndCovarianceMatrix (const boost::shared_
         covariance_matrix.coeffRef(6) = covariance_matrix.coeff(2);
         covariance_matrix.coeffRef(7) = covariance_matrix.coeff(5);
     }
-    ROS_DEBUG_NAMED("Computed Mean Covariance Matrix","Calculated Points: %f", static_cast<float>(point_count));
     return (point_count);
 }
 
@@ -413,10 +463,30 @@ nimbus::BoxDetector<PointType>::boxYaw(const boost::shared_ptr<const pcl::PointC
                                        const Eigen::Vector4f &centroid,
                                        float &yaw)
 {
-    Eigen::Matrix<float, 4, 2> corners;
-    corners.setZero();
     bool ready = this->getMeanCorners(blob, 5);
     if(!ready) return false;
+    return yawFromMeanCorners(width, length, centroid, yaw);
+}
+
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::boxYaw(const SoAFrame &frame, const Bitmask &mask,
+                                       const float width, const float length,
+                                       const Eigen::Vector4f &centroid,
+                                       float &yaw)
+{
+    bool ready = this->getMeanCorners(frame, mask, 5);
+    if(!ready) return false;
+    return yawFromMeanCorners(width, length, centroid, yaw);
+}
+
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::yawFromMeanCorners(const float width, const float length,
+                                                   const Eigen::Vector4f &centroid,
+                                                   float &yaw)
+{
+    Eigen::Matrix<float, 4, 2> corners;
     corners = cornerBuffer;
     cornerBuffer.setZero();
     // Calculate the best corner 
@@ -435,7 +505,6 @@ nimbus::BoxDetector<PointType>::boxYaw(const boost::shared_ptr<const pcl::PointC
         case 0:
             m = static_cast<float>(slope(corners(0, 0), corners(0, 1), centroid[0], centroid[1]));
             angle = atan(m);
-            ROS_ERROR("Actual slope: %f", (angle * 180)/M_PI);
             // Look Ymin side is Length or width
             this->selectSide(corners(0, 0), corners(0, 1), corners(2,0), corners(2,1), width, length, sideSelect);
             if (sideSelect == Side::LENGTH){
@@ -445,7 +514,6 @@ nimbus::BoxDetector<PointType>::boxYaw(const boost::shared_ptr<const pcl::PointC
                 } else{
                     yaw =  angle + box_max_angle;
                 }
-                ROS_ERROR ("Xmin - Length Side Slope angle: %f, yaw: %f", (angle * 180)/M_PI, (yaw * 180)/M_PI);
             }
             if(sideSelect == Side::WIDTH){
                 if(((angle * 180)/M_PI) < 0){
@@ -455,13 +523,11 @@ nimbus::BoxDetector<PointType>::boxYaw(const boost::shared_ptr<const pcl::PointC
                 } else{
                     yaw = angle - box_max_angle;
                 }
-                ROS_ERROR ("Xmin - Width Side Slope angle: %f, yaw: %f", (angle * 180)/M_PI, (yaw * 180)/M_PI);
             }
             break;
         case 1:
             m = static_cast<float>(slope(corners(1, 0), corners(1, 1), centroid[0], centroid[1]));
             angle = atan(m);
-            ROS_ERROR("Actual slope: %f", (angle * 180)/M_PI);
             // Look Ymin side is Length or width
             this->selectSide(corners(1,0), corners(1,1), corners(2,0), corners(2,1), width, length, sideSelect);
             if (sideSelect == Side::LENGTH){
@@ -470,7 +536,6 @@ nimbus::BoxDetector<PointType>::boxYaw(const boost::shared_ptr<const pcl::PointC
                 }else{
                     yaw = angle - box_max_angle;
                 }
-                ROS_ERROR ("Xmax - Length Side Slope angle: %f, yaw: %f", (angle * 180)/M_PI, (yaw * 180)/M_PI);
             }
             if(sideSelect == Side::WIDTH){
                 if(((angle * 180)/M_PI) < 0){
@@ -478,61 +543,117 @@ nimbus::BoxDetector<PointType>::boxYaw(const boost::shared_ptr<const pcl::PointC
                 }else{
                     yaw =  angle + (M_PI/2) - box_min_angle;
                 }
-                ROS_ERROR ("Xmax - Width Side Slope angle: %f, yaw: %f", (angle * 180)/M_PI, (yaw * 180)/M_PI);
             }
             break;
         case 2:
             m = static_cast<float>(slope(corners(2, 0), corners(2, 1), centroid[0], centroid[1]));
             angle = atan(m);
-            ROS_ERROR("Actual slope: %f", (angle * 180)/M_PI);
             // Look Xmin side is Length or width
             this->selectSide(corners(2,0), corners(2,1), corners(0,0), corners(0,1), width, length, sideSelect);
             if (sideSelect == Side::LENGTH){
                 if((angle * 180)/M_PI < 0) yaw = angle - box_min_angle; // Check the sign of angle
                 else yaw = angle - box_max_angle; // Todo
-                ROS_ERROR ("Ymin - Length Side Slope angle: %f, yaw: %f", (angle * 180)/M_PI, (yaw * 180)/M_PI);
             }
             if(sideSelect == Side::WIDTH){
                 if((angle * 180)/M_PI < 0) yaw = angle - box_max_angle; // ToDo
                 else yaw = angle - box_max_angle;
-                ROS_ERROR ("Ymin - Width Side Slope angle: %f, yaw: %f", (angle * 180)/M_PI, (yaw * 180)/M_PI);
             }
             break;
         case 3:
             m = static_cast<float>(slope(corners(3,0), corners(3, 1), centroid[0], centroid[1]));
             angle = atan(m);
-            ROS_ERROR("Actual slope: %f", (angle * 180)/M_PI);
             // Look Xmin side is Length or width
             this->selectSide(corners(3,0), corners(3,1), corners(0,0), corners(0,1), width, length, sideSelect);
             if (sideSelect == Side::LENGTH){
                 if((angle * 180)/M_PI < 0) yaw =  angle + box_min_angle + (M_PI/2);
                 else yaw = angle - box_min_angle + (M_PI/2);
-                ROS_ERROR ("Ymax - Length Side Slope angle: %f, yaw: %f", (angle * 180)/M_PI, (yaw * 180)/M_PI);
             }
             if(sideSelect == Side::WIDTH){
                 if((angle * 180)/M_PI < 0) yaw =  box_max_angle + angle; // Check the sign of angle
                 else yaw = angle - box_max_angle; 
-                ROS_ERROR ("Ymax - Width Side Slope angle: %f, yaw: %f", (angle * 180)/M_PI, (yaw * 180)/M_PI);
             }
             break;
     }
 
-    _marker.lifetime = ros::Duration(); 
-    _marker.pose.position.x = centroid[0];
-    _marker.pose.position.y = centroid[1];
-    _marker.pose.position.z = centroid[2];
-    tf2::Quaternion q;
-    q.setRPY(0, 0, yaw);
-    _marker.pose.orientation = tf2::toMsg(q);
-    _marker.scale.x = width;
-    _marker.scale.y = length;
-    _marker.scale.z = 0.001;
-    _pub_marker.publish(_marker);
     return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::boxYawMinAreaRect(const boost::shared_ptr<const pcl::PointCloud<pcl::PointXYZ>> &blob,
+                                                  const Eigen::Vector3f &normal, float topTolerance,
+                                                  float &yaw, float &length, float &width)
+{
+    // Plane basis, u follows the camera x axis so that yaw is comparable with boxYaw
+    Eigen::Vector3f n = normal.normalized();
+    Eigen::Vector3f u = Eigen::Vector3f::UnitX() - n * n.x();
+    if(u.norm() < 1e-3f) u = Eigen::Vector3f::UnitY() - n * n.y();
+    u.normalize();
+    Eigen::Vector3f v = n.cross(u);
+
+    std::vector<float> heights;
+    heights.reserve(blob->points.size());
+    for(const auto &point: blob->points)
+    {
+        if(!pcl::isFinite(point)) continue;
+        heights.push_back(n.dot(point.getVector3fMap()));
+    }
+    if(heights.size() < 3) return false;
+    // Top face is the closest to the camera, skip the first 2% as flying pixels
+    std::vector<float> sorted(heights);
+    std::size_t k = sorted.size() / 50;
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    float top = sorted[k];
+
+    std::vector<Eigen::Vector2f> face;
+    face.reserve(heights.size());
+    std::size_t h = 0;
+    for(const auto &point: blob->points)
+    {
+        if(!pcl::isFinite(point)) continue;
+        if(heights[h++] > top + topTolerance) continue;
+        face.push_back(Eigen::Vector2f(u.dot(point.getVector3fMap()), v.dot(point.getVector3fMap())));
+    }
+
+    std::vector<Eigen::Vector2f> hull;
+    nimbus::convexHull(face, hull);
+    nimbus::RotatedRect rect;
+    if(!nimbus::minAreaRect(hull, rect)) return false;
+
+    length = rect.length;
+    width = rect.width;
+    // Box y axis is along the length side
+    yaw = rect.yaw - static_cast<float>(M_PI / 2);
+    if(yaw < -M_PI / 2) yaw += M_PI;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::boxCuboid(const SoAFrame &frame, const Bitmask &mask,
+                                          const Eigen::Vector4f &table, Cuboid &cuboid)
+{
+    Eigen::Vector4f top;
+    float curvature;
+    if(!_robustPlane.fit(frame, mask, top, curvature)) return false;
+    return boxCuboid(frame, mask, top, table, cuboid);
+}
+
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::boxCuboid(const SoAFrame &frame, const Bitmask &mask, const Eigen::Vector4f &top,
+                                          const Eigen::Vector4f &table, Cuboid &cuboid)
+{
+    // Twice the inlier distance keeps the noisy rim of the top face in the hull
+    return nimbus::estimateCuboid(frame, mask, top, table, 2 * _robustPlane.threshold(), cuboid);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 template <class PointType>
 void 
 nimbus::BoxDetector<PointType>::selectSide(const float x1, const float y1, const float x2, const float y2, 
@@ -600,6 +721,39 @@ nimbus::BoxDetector<PointType>::getMeanCorners(const boost::shared_ptr<const pcl
             corners(3, 0) = cloud.points[j].x;
         }
     }
+    return accumulateCorners(corners, frameSize);
+}
+
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::getMeanCorners(const SoAFrame &frame, const Bitmask &mask, int frameSize)
+{
+    Bitmask selection = frame.valid;
+    selection &= mask;
+    if(selection.count() == 0) return false;
+    // Start from the first box pixel, not from the origin
+    Eigen::Matrix<float, 4, 2> corners;
+    bool first = true;
+    selection.forEach([&](std::size_t i){
+        const float x = frame.x[i], y = frame.y[i];
+        if(first)
+        {
+            corners << x, y, x, y, x, y, x, y;
+            first = false;
+            return;
+        }
+        if(x < corners(0, 0)) corners.row(0) << x, y;      // Xmin
+        if(x > corners(1, 0)) corners.row(1) << x, y;      // Xmax
+        if(y < corners(2, 1)) corners.row(2) << x, y;      // Ymin
+        if(y > corners(3, 1)) corners.row(3) << x, y;      // Ymax
+    });
+    return accumulateCorners(corners, frameSize);
+}
+
+template <class PointType>
+bool 
+nimbus::BoxDetector<PointType>::accumulateCorners(const Eigen::Matrix<float, 4, 2> &corners, int frameSize)
+{
     if(cornerBufferCounter <= frameSize){
         cornerBufferCounter += 1;
         cornerBuffer(0, 0) += corners(0, 0);
@@ -655,53 +809,56 @@ nimbus::BoxDetector<PointType>::meanFilter(pcl::SynchronizedQueue<pcl::PointClou
                                             pcl::PointCloud<pcl::PointXYZ> &res)
 {
     if (queue.isEmpty()) return;
-    typename pcl::PointCloud<PointType>::Ptr tempC (new pcl::PointCloud<PointType>());
-    queue.dequeue(*tempC);
-
-    int width = tempC->width;
-    int height = tempC->height;
-
-    std::vector<float> conf(width*height, 0);
-    std::vector<float> mnCounter(width*height, 0);
-    std::vector<float> addX(width*height, 0);
-    std::vector<float> addY(width*height, 0);
-    std::vector<float> addZ(width*height, 0);
-    
-    res.width = width;
-    res.height = height;
-    res.header   = tempC->header;
-    res.is_dense = tempC->is_dense;
-    res.sensor_orientation_ = tempC->sensor_orientation_;
-    res.sensor_origin_ = tempC->sensor_origin_;
-
-    while (!queue.isEmpty()){
-        int i = 0;
-        for(int i = 0; i < tempC->points.size(); i++){
-            if(!std::isnan(tempC->points[i].z)){
-                addX[i] += tempC->points[i].x;
-                addY[i] += tempC->points[i].y;
-                addZ[i] += tempC->points[i].z;
-                mnCounter[i] +=1;
-            }else{
-                conf[i] = 1;
-                mnCounter[i] = 0;
-            }
+    // Running sums in the result, only one queued frame is held at a time
+    pcl::PointCloud<pcl::PointXYZ> frame;
+    queue.dequeue(frame);
+    const std::size_t size = frame.points.size();
+    const std::size_t width = std::max<std::size_t>(frame.width, 1);
+    const std::size_t rows = (size + width - 1) / width;
+
+    res.width = frame.width;
+    res.height = frame.height;
+    res.header   = frame.header;
+    res.sensor_orientation_ = frame.sensor_orientation_;
+    res.sensor_origin_ = frame.sensor_origin_;
+    res.points.assign(size, pcl::PointXYZ(0, 0, 0));
+    std::vector<float> mnCounter(size, 0);
+    while (true){
+        // Frames of another layout are skipped
+        if(frame.points.size() == size)
+        {
+            parallelRows(rows, width, _bands, [&](std::size_t begin, std::size_t end, unsigned int){
+                end = std::min(end * width, size);
+                for(std::size_t i = begin * width; i < end; ++i)
+                {
+                    const pcl::PointXYZ &p = frame.points[i];
+                    if(std::isnan(p.z)) continue;
+                    res.points[i].x += p.x;
+                    res.points[i].y += p.y;
+                    res.points[i].z += p.z;
+                    mnCounter[i] += 1;
+                }
+            });
         }
-        queue.dequeue(*tempC);
+        if(queue.isEmpty()) break;
+        queue.dequeue(frame);
     }
-    for(int i = 0; i < mnCounter.size(); i++){
-        PointType temPoint;
-        if(mnCounter[i] == 0){
-            temPoint.x = NAN;
-            temPoint.y = NAN;
-            temPoint.z = NAN;
-        }else{
-            temPoint.x = addX[i] / mnCounter[i];
-            temPoint.y = addY[i] / mnCounter[i];
-            temPoint.z = addZ[i] / mnCounter[i];
+    parallelRows(rows, width, _bands, [&](std::size_t begin, std::size_t end, unsigned int){
+        end = std::min(end * width, size);
+        for(std::size_t i = begin * width; i < end; ++i)
+        {
+            PointType &temPoint = res.points[i];
+            if(mnCounter[i] == 0){
+                temPoint.x = NAN;
+                temPoint.y = NAN;
+                temPoint.z = NAN;
+            }else{
+                temPoint.x /= mnCounter[i];
+                temPoint.y /= mnCounter[i];
+                temPoint.z /= mnCounter[i];
+            }
         }
-        res.points.push_back(temPoint);
-    }
+    });
     res.is_dense = false;
 }
 
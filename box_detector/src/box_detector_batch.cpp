@@ -0,0 +1,130 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file box_detector_batch.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Offline evaluation of the box detector over recorded PCD frames, no ROS required.
+ *
+ * Usage: box_detector_batch <ground_truth.pcd> <frame_dir> [box_width box_length box_height per_width per_height]
+ * Writes one CSV line per frame: file, centroid x/y/z, yaw (deg), valid, followed by the
+ * single frame minimum area rectangle yaw (deg), length and width for A/B comparison
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <pcl/io/pcd_io.h>
+
+#include <box_detector/box_detector.hpp>
+
+typedef pcl::PointXYZ PointType;
+typedef pcl::PointCloud<PointType> PointCloud;
+
+int main(int argc, char** argv){
+    if(argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <ground_truth.pcd> <frame_dir> "
+                  << "[box_width box_length box_height per_width per_height]" << std::endl;
+        return 1;
+    }
+    // Same defaults as box_detector.launch
+    double width = 0.075, length = 0.20, height = 0.15, per_width = 0.60, per_height = 0.4;
+    if(argc >= 8)
+    {
+        width = std::stod(argv[3]);
+        length = std::stod(argv[4]);
+        height = std::stod(argv[5]);
+        per_width = std::stod(argv[6]);
+        per_height = std::stod(argv[7]);
+    }
+
+    PointCloud::Ptr ground (new PointCloud());
+    if(pcl::io::loadPCDFile(argv[1], *ground) != 0)
+    {
+        std::cerr << "Can not read ground truth " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::vector<boost::filesystem::path> frames;
+    for(boost::filesystem::directory_iterator it(argv[2]), end; it != end; ++it)
+    {
+        if(it->path().extension() == ".pcd") frames.push_back(it->path());
+    }
+    std::sort(frames.begin(), frames.end());
+
+    nimbus::BoxDetector<PointType> boxDetect;
+    pcl::SynchronizedQueue<PointCloud> queue;
+    Eigen::Vector4f centroid;
+    float yaw = 0;
+    float rectYaw = 0, rectLength = 0, rectWidth = 0;
+    std::size_t processed = 0;
+    double elapsed = 0;
+
+    std::cout << "file,x,y,z,yaw,valid,rect_yaw,rect_length,rect_width,rect_valid" << std::endl;
+    for(const auto &frame: frames)
+    {
+        PointCloud::Ptr blob (new PointCloud());
+        if(pcl::io::loadPCDFile(frame.string(), *blob) != 0) continue;
+
+        auto start = std::chrono::steady_clock::now();
+        PointCloud::Ptr rCloud (new PointCloud());
+        PointCloud::Ptr meanCloud (new PointCloud());
+        PointCloud::Ptr cloud (new PointCloud());
+        boxDetect.outlineRemover(blob, blob->width, blob->height, per_width, per_height, *rCloud);
+        // A ground truth in the sensor layout gets the same organized crop as the frames
+        if(ground->points.size() != rCloud->points.size() && ground->width == blob->width && ground->height == blob->height)
+        {
+            PointCloud::Ptr croppedGround (new PointCloud());
+            boxDetect.outlineRemover(ground, ground->width, ground->height, per_width, per_height, *croppedGround);
+            ground = croppedGround;
+        }
+        queue.enqueue(*rCloud);
+        if(queue.size() < 2) continue;
+        boxDetect.meanFilter(queue, *meanCloud);
+        // Empty path: never delete the user supplied ground truth
+        if(!boxDetect.getBaseModel(ground, meanCloud, height - 0.04, boost::filesystem::path(), *cloud))
+        {
+            std::cerr << frame.filename().string() << ": ground truth has " << ground->points.size()
+                      << " points, the cropped frame " << meanCloud->points.size() << std::endl;
+            continue;
+        }
+        boxDetect.box3DCentroid(cloud, centroid);
+        bool valid = !std::isnan(centroid[0]) && boxDetect.boxYaw(cloud, width, length, centroid, yaw);
+        bool rectValid = boxDetect.boxYawMinAreaRect(cloud, Eigen::Vector3f::UnitZ(), 0.01f,
+                                                     rectYaw, rectLength, rectWidth);
+        elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++processed;
+
+        std::cout << frame.filename().string() << "," << centroid[0] << "," << centroid[1] << ","
+                  << centroid[2] << "," << (yaw * 180)/M_PI << "," << valid << ","
+                  << (rectYaw * 180)/M_PI << "," << rectLength << "," << rectWidth << "," << rectValid << std::endl;
+    }
+    if(processed != 0)
+        std::cerr << "Processed " << processed << " frames, " << (elapsed * 1000.0) / processed << " ms/frame" << std::endl;
+    return 0;
+}
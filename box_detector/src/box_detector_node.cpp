@@ -35,6 +35,11 @@
 #include <tf2_ros/static_transform_broadcaster.h>
 #include <tf2_ros/transform_listener.h>
 #include <geometry_msgs/TransformStamped.h>
+#include <geometry_msgs/PoseArray.h>
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
+#include <std_msgs/String.h>
+#include <visualization_msgs/Marker.h>
+#include <iwtros_msgs/objectDetections.h>
 
 #include <pcl_ros/point_cloud.h>
 #include <pcl/io/impl/synchronized_queue.hpp>
@@ -44,51 +49,172 @@
 #include <boost/filesystem.hpp>
 
 #include <box_detector/box_detector.hpp>
+#include <box_detector/box_segmentation.hpp>
+#include <box_detector/box_tracker.hpp>
+#include <box_detector/workspace_roi.hpp>
+#include <box_detector/table_plane.hpp>
+#include <box_detector/sku_classifier.hpp>
 
 typedef pcl::PointXYZ PointType;
 typedef pcl::PointCloud<PointType> PointCloud;
 
 class Detector{
     private:
+        /** Measured pose of one blob in the camera frame */
+        struct BlobPose
+        {
+            Eigen::Vector3f position;       // Center of the top face
+            Eigen::Quaternionf orientation;
+            float yaw = 0;
+            float length = 0, width = 0;
+            float height = std::numeric_limits<float>::quiet_NaN();
+            bool yawValid = false;          // false while the corner buffer averages, yaw is the principal axis then
+            bool measured = false;          // Accepted cuboid, orientation keeps roll and pitch
+            bool fitted = false;            // cuboid holds the top face fit, also if not accepted
+            nimbus::Cuboid cuboid;
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        };
+        typedef std::vector<BlobPose, Eigen::aligned_allocator<BlobPose> > BlobPoses;
+
         ros::NodeHandle _nh; 
         ros::Subscriber _sub;
         ros::Publisher _pub;
         ros::Publisher _pubPose;
+        ros::Publisher _pubMarker;
+        ros::Publisher _pubPoses;
+        ros::Publisher _pubObjects;
+        ros::Publisher _pubTracked;
+        ros::Publisher _pubSkus;
+        ros::Publisher _pubAmbiguous;
         PointCloud::Ptr _cloud;
         tf2_ros::Buffer buffer;
-        pcl::SynchronizedQueue<pcl::PointCloud<pcl::PointXYZ>> _queue;
+        tf2_ros::TransformListener listener;
+        // Compact depth frames, the rays are shared by all frames of the sensor
+        pcl::SynchronizedQueue<nimbus::DepthFrame> _queue;
+        nimbus::RayTable::Ptr _rays;
+        // Crop window of the queued frames, row and col of -1 for the border crop
+        Eigen::Vector4i _window = Eigen::Vector4i::Zero();
+        // Reference in the full sensor layout, _ground is its crop to the window of the live frames
+        PointCloud _groundCloud;
+        pcl::SynchronizedQueue<nimbus::DepthFrame> _groundQueue;
+        nimbus::RayTable::Ptr _groundRays;
+        nimbus::DepthFrame _ground;
+        Eigen::Vector4i _groundWindow = Eigen::Vector4i::Zero();
+        nimbus::SoAFrame _input, _cropped, _foreground;
+        nimbus::Bitmask _boxMask, _blobMask;
+        // "reference": captured empty table, "plane": table plane fitted per frame
+        std::string background = "reference";
+        nimbus::TablePlane _table;
+        nimbus::Bitmask _tableMask;
+        // Table plane of the reference capture, fitted once for the box height
+        nimbus::TablePlane _groundTable;
+        // Workspace box in the robot frame, reprojected when the extrinsics change
+        nimbus::WorkspaceROI _roi;
+        nimbus::RayTable _sensorRays;
+        Eigen::Isometry3f _roiExtrinsics, _roiBox;
+        Eigen::Vector3f _roiSize;
+        std::string roi_frame = "iiwa_link_0";
+        double roi_x = 0, roi_y = 0, roi_z = 0, roi_yaw = 0, roi_size_x = 0, roi_size_y = 0, roi_size_z = 0;
 
         bool _newCloud = false;
         std::mutex cloud_lock;
         double distance_max, distance_min, per_width, per_height, width, length, height;
+        double segment_depth_jump = 0.01;
+        int segment_min_points = 50;
+        int mask_opening = 1;
+        double plane_threshold = 0.005;
+        std::string plane_estimator = "ransac";
+        nimbus::RowBands bands;
+        double top_tolerance = 0.01;
+        double cuboid_min_quality = 0.5;
+        bool cuboid_refine = true;
+        YawMethod yaw_method = YawMethod::CORNERS;
 
         nimbus::BoxDetector<pcl::PointXYZ> * boxDectect;
+        nimbus::BoxSegmentation<pcl::PointXYZ> segmentation;
+        nimbus::BoxBlobs blobs;
+        nimbus::BoxTracker tracker;
+        // Box types on the line, blobs are matched by their measured dimensions
+        nimbus::SkuClassifier skus;
+        double tracker_q_pos = 0.01, tracker_q_yaw = 0.05, tracker_r_pos = 0.005, tracker_r_yaw = 0.05;
+        double tracker_timeout = 2.0, tracker_gate = 20.0;
 
-        Eigen::Matrix<float, 4, 1> centroid, param_norm;
-        float yaw = 0;
 
         tf2_ros::StaticTransformBroadcaster broadCaster;
         geometry_msgs::TransformStamped pose;
+        visualization_msgs::Marker marker;
 
         unsigned int yawCounter;
         
     public:
-        Detector(ros::NodeHandle nh): _nh(nh)
+        Detector(ros::NodeHandle nh): _nh(nh), listener(buffer), _rays(new nimbus::RayTable()),
+                                     _groundRays(new nimbus::RayTable())
         {
             _sub = _nh.subscribe<sensor_msgs::PointCloud2>("/nimbus/pointcloud", 10, boost::bind(&Detector::callback, this, _1));
             _pub = _nh.advertise<PointCloud>("filtered_cloud", 5);
             _pubPose = _nh.advertise<geometry_msgs::TransformStamped>("detected_pose", 10);
-            tf2_ros::TransformListener listener(buffer);
+            _pubMarker = _nh.advertise<visualization_msgs::Marker>("bounding_box", 1);
+            _pubPoses = _nh.advertise<geometry_msgs::PoseArray>("detected_poses", 10);
+            _pubObjects = _nh.advertise<iwtros_msgs::objectDetections>("detected_objects", 10);
+            _pubTracked = _nh.advertise<geometry_msgs::PoseWithCovarianceStamped>("tracked_pose", 10);
+            _pubSkus = _nh.advertise<std_msgs::String>("detected_skus", 10);
+            _pubAmbiguous = _nh.advertise<PointCloud>("sku_ambiguous", 5);
+            loadSkus(_nh);
 
 
-            this->boxDectect = new nimbus::BoxDetector<pcl::PointXYZ>(_nh);
+            this->boxDectect = new nimbus::BoxDetector<pcl::PointXYZ>();
 
             pose.header.frame_id = "camera";
             pose.child_frame_id = "box";
             yawCounter = 0;
+
+            marker.header.frame_id = "camera";
+            marker.ns = "basic_shapes";
+            marker.id = 0;
+            marker.type = visualization_msgs::Marker::CUBE;
+            marker.action = visualization_msgs::Marker::ADD;
+            marker.color.r = 0.0f;
+            marker.color.g = 1.0f;
+            marker.color.b = 0.0f;
+            marker.color.a = 1.0;
+            marker.lifetime = ros::Duration();
+        }
+
+        ~Detector(){ delete boxDectect; }
+
+        static double number(XmlRpc::XmlRpcValue &value)
+        {
+            if(value.getType() == XmlRpc::XmlRpcValue::TypeInt) return static_cast<int>(value);
+            return static_cast<double>(value);
         }
 
-        ~Detector(){}
+        /**
+         * SKU table, e.g. skus: [{name: small, length: 0.2, width: 0.075, height: 0.15, tolerance: 0.01}].
+         * Without a table no blob is classified.
+         */
+        void loadSkus(ros::NodeHandle nh)
+        {
+            XmlRpc::XmlRpcValue list;
+            if(!nh.getParam("skus", list) || list.getType() != XmlRpc::XmlRpcValue::TypeArray) return;
+            for(int i = 0; i < list.size(); ++i)
+            {
+                try{
+                    nimbus::Sku sku;
+                    sku.name = static_cast<std::string>(list[i]["name"]);
+                    sku.length = number(list[i]["length"]);
+                    sku.width = number(list[i]["width"]);
+                    sku.height = list[i].hasMember("height") ? number(list[i]["height"]) : 0;
+                    sku.tolerance = list[i].hasMember("tolerance") ? number(list[i]["tolerance"]) : 0.01;
+                    if(!skus.add(sku)) ROS_WARN("SKU %s needs a positive tolerance", sku.name.c_str());
+                }catch(XmlRpc::XmlRpcException &e){
+                    ROS_WARN("Invalid SKU %d: %s", i, e.getMessage().c_str());
+                }
+            }
+            double margin = 0.5;
+            nh.getParam("sku_margin", margin);
+            skus.setMargin(margin);
+            ROS_INFO("%zu SKUs loaded", skus.size());
+        }
 
         void callback(const sensor_msgs::PointCloud2::ConstPtr &msg)
         {
@@ -112,14 +238,200 @@ class Detector{
             nh.getParam("box_width", width);
             nh.getParam("box_length", length);
             nh.getParam("box_height", height);
+            nh.getParam("segment_depth_jump", segment_depth_jump);
+            nh.getParam("segment_min_points", segment_min_points);
+            segmentation.setDepthJump(segment_depth_jump);
+            segmentation.setMinPoints(segment_min_points);
+            nh.getParam("mask_opening", mask_opening);
+            int threads = 0;
+            nh.getParam("threads", threads);
+            nh.getParam("deterministic", bands.deterministic);
+            bands.threads = static_cast<unsigned int>(std::max(threads, 0));
+            boxDectect->setParallel(bands.threads, bands.deterministic);
+            nh.getParam("background", background);
+            nh.getParam("plane_threshold", plane_threshold);
+            nh.getParam("plane_estimator", plane_estimator);
+            boxDectect->setRobustPlane(plane_threshold, 0.99f, 200, 4096,
+                                       plane_estimator == "lmeds" ? PlaneEstimator::LMEDS : PlaneEstimator::RANSAC);
+            nh.getParam("roi_frame", roi_frame);
+            nh.getParam("roi_x", roi_x);
+            nh.getParam("roi_y", roi_y);
+            nh.getParam("roi_z", roi_z);
+            nh.getParam("roi_yaw", roi_yaw);
+            nh.getParam("roi_size_x", roi_size_x);
+            nh.getParam("roi_size_y", roi_size_y);
+            nh.getParam("roi_size_z", roi_size_z);
+            nh.getParam("top_tolerance", top_tolerance);
+            nh.getParam("cuboid_min_quality", cuboid_min_quality);
+            nh.getParam("cuboid_refine", cuboid_refine);
+            nh.getParam("tracker_q_pos", tracker_q_pos);
+            nh.getParam("tracker_q_yaw", tracker_q_yaw);
+            nh.getParam("tracker_r_pos", tracker_r_pos);
+            nh.getParam("tracker_r_yaw", tracker_r_yaw);
+            nh.getParam("tracker_timeout", tracker_timeout);
+            nh.getParam("tracker_gate", tracker_gate);
+            tracker.setNoise(tracker_q_pos, tracker_q_yaw, tracker_r_pos, tracker_r_yaw);
+            tracker.setTimeout(tracker_timeout);
+            tracker.setGate(tracker_gate);
+            std::string method;
+            if(nh.getParam("yaw_method", method))
+            {
+                if(method == "min_area_rect") yaw_method = YawMethod::MIN_AREA_RECT;
+                else if(method == "corners") yaw_method = YawMethod::CORNERS;
+                else if(method == "cuboid") yaw_method = YawMethod::CUBOID;
+                else if(method == "contour") yaw_method = YawMethod::CONTOUR;
+                else ROS_WARN_ONCE("Unknown yaw_method %s, use corners, min_area_rect, cuboid or contour", method.c_str());
+            }
+        }
+
+        /**
+         * All boxes of one frame in a single message, the pose of each box from the configured estimator.
+         * names and scores come from the SKU classifier, without it every blob is a "box" with score 1.
+         */
+        void publishBlobs(const BlobPoses &boxes, const std::vector<std::string> &names,
+                          const std::vector<float> &scores, const ros::Time &stamp)
+        {
+            geometry_msgs::PoseArray poses;
+            poses.header.frame_id = "camera";
+            poses.header.stamp = stamp;
+            iwtros_msgs::objectDetections objects;
+            objects.header = poses.header;
+            for(std::size_t b = 0; b < boxes.size(); ++b)
+            {
+                const BlobPose &box = boxes[b];
+                geometry_msgs::Pose p;
+                p.position.x = box.position[0];
+                p.position.y = box.position[1];
+                p.position.z = box.position[2];
+                p.orientation.x = box.orientation.x();
+                p.orientation.y = box.orientation.y();
+                p.orientation.z = box.orientation.z();
+                p.orientation.w = box.orientation.w();
+                poses.poses.push_back(p);
+                iwtros_msgs::detectedObject object;
+                object.model_id = b < names.size() ? names[b] : "box";
+                object.pose = p;
+                object.score = b < scores.size() ? scores[b] : 1.0f;
+                objects.objects.push_back(object);
+            }
+            _pubPoses.publish(poses);
+            objects.latency = ros::Time::now() - stamp;
+            _pubObjects.publish(objects);
+        }
+
+        /**
+         * Pose of one blob with the configured yaw_method, the position is the center of the top face.
+         * The corner buffer averages over frames of one box, so only the largest blob (first) uses
+         * CORNERS, the others the minimum area rectangle.
+         */
+        void measureBlob(const PointCloud::Ptr &foreground, std::size_t b, const Eigen::Vector4f &table, BlobPose &res)
+        {
+            const nimbus::BoxBlob &blob = blobs[b];
+            nimbus::Bitmask &mask = b == 0 ? _boxMask : _blobMask;
+            mask.reset(_foreground.width(), _foreground.height());
+            for(int i: blob.indices) mask.set(i);
+            res = BlobPose();
+            res.length = length;
+            res.width = width;
+            // Segmentation statistics until something better is measured
+            res.position = blob.centroid.head<3>();
+            res.yaw = blob.yaw;
+            Eigen::Vector4f center;
+            boxDectect->box3DCentroid(_foreground, mask, center);
+            if(!std::isnan(center[0])) res.position = center.head<3>();
+            // Robust top face normal, the table normal is only assumed if the fit fails
+            Eigen::Vector3f topNormal = Eigen::Vector3f::UnitZ();
+            Eigen::Vector4f top;
+            float curvature = 0;
+            nimbus::Cuboid &cuboid = res.cuboid;
+            bool &fitted = res.fitted;
+            if(boxDectect->computePointNormal(_foreground, mask, top, curvature))
+            {
+                topNormal = -top.head<3>();
+                ROS_DEBUG("Top face tilt :%f curvature :%f", std::acos(std::min(1.0f, topNormal[2])) * 180 / M_PI, curvature);
+                // One cuboid on the fitted plane, the mean of all pixels is pulled towards the visible sides
+                fitted = boxDectect->boxCuboid(_foreground, mask, top, table, cuboid);
+                if(fitted) res.position = cuboid.topCenter;
+            }
+            if(yaw_method == YawMethod::CUBOID)
+            {
+                res.measured = fitted && cuboid.quality >= cuboid_min_quality;
+                // Direct depth refinement, needs the height from the table plane
+                if(res.measured && cuboid_refine && boxDectect->refineCuboid(_foreground, mask, cuboid))
+                {
+                    const Eigen::Matrix3f R = cuboid.orientation.toRotationMatrix();
+                    cuboid.yaw = std::atan2(R(1, 0), R(0, 0));
+                    ROS_DEBUG("Cuboid refined in %d iterations, rms :%f converged :%d", boxDectect->cuboidRefiner().iterations(),
+                              boxDectect->cuboidRefiner().rms(), boxDectect->cuboidRefiner().converged());
+                }
+                if(res.measured)
+                {
+                    ROS_DEBUG("Cuboid %f x %f x %f tilt :%f quality :%f", cuboid.length, cuboid.width,
+                              cuboid.height, cuboid.tilt * 180 / M_PI, cuboid.quality);
+                    res.position = cuboid.topCenter;
+                    res.yaw = cuboid.yaw;
+                    res.length = cuboid.length;
+                    res.width = cuboid.width;
+                    res.height = cuboid.height;
+                }else{
+                    ROS_WARN_THROTTLE(5, "Cuboid rejected, falling back to the minimum area rectangle");
+                }
+            }
+            float yaw = res.yaw;
+            if(res.measured)
+                res.yawValid = true;
+            else if(yaw_method == YawMethod::CONTOUR)
+                res.yawValid = boxDectect->boxYawContour(_foreground, mask, topNormal, yaw, res.length, res.width);
+            else if(yaw_method == YawMethod::CORNERS && b == 0)
+                res.yawValid = !std::isnan(center[0]) && boxDectect->boxYaw(_foreground, mask, width, length, center, yaw);
+            else
+            {
+                PointCloud::Ptr boxCloud (new PointCloud());
+                segmentation.blobCloud(foreground, blob, *boxCloud);
+                res.yawValid = boxDectect->boxYawMinAreaRect(boxCloud, topNormal, top_tolerance,
+                                                             yaw, res.length, res.width);
+            }
+            if(res.yawValid) res.yaw = yaw;
+            if((res.yaw * 180)/M_PI > 90) res.yaw = res.yaw - M_PI;
+            if((res.yaw * 180)/M_PI < -90) res.yaw = res.yaw + M_PI;
+            // Measured roll and pitch of a tilted box, else the yaw around the camera axis
+            if(res.measured)
+                res.orientation = cuboid.orientation;
+            else
+                res.orientation = Eigen::AngleAxisf(res.yaw, Eigen::Vector3f::UnitZ());
         }
 
-        bool groudTruth(const boost::shared_ptr< const pcl::PointCloud<pcl::PointXYZ>> blob, pcl::PointCloud<pcl::PointXYZ> &res)
+        /**
+         * Crop to the workspace ROI if it is available, else the border crop. The reference and
+         * the live frames go through here so both always share one window.
+         * window is (row, col, width, height), row and col are -1 for the border crop.
+         */
+        void cropFrame(const PointCloud &cloud, bool roi, nimbus::SoAFrame &res, Eigen::Vector4i &window)
+        {
+            if(roi)
+            {
+                // Only the pixels that can see the workspace are visited
+                _roi.crop(cloud, res, bands);
+                window << _roi.rowBegin(), _roi.colBegin(), res.width(), res.height();
+            }else{
+                _input.fromCloud(cloud);
+                _input.crop(per_width, per_height, res, bands);
+                window << -1, -1, res.width(), res.height();
+            }
+        }
+
+        /**
+         * Foreground against the empty table reference. The reference is captured once in the full
+         * sensor layout and cropped with the window of the live frames, a ROI or crop change only
+         * re-crops it. The file is never replaced, delete it to capture a new one.
+         * @param sensor Uncropped frame, averaged for the first capture
+         * @param frame Mean frame of the current window
+         * @param roi Frame was cropped to the workspace ROI
+         */
+        bool groudTruth(const PointCloud &sensor, const nimbus::DepthFrame &frame, bool roi, nimbus::SoAFrame &res)
         {
             std::string model_name = "/grount_truth";
             std::string extention = ".pcd";
-            std::string saved_groudtruth;
-            int counter = 0;
             std::stringstream dir;
             std::string _working_dir = getenv("HOME");
             dir << _working_dir << "/ros_ws/ground";
@@ -132,25 +444,279 @@ class Detector{
             }
             std::stringstream file;
             file << test_dir.c_str() << model_name << extention;
-            if(!boost::filesystem::exists(file.str()))
+            if(_groundCloud.empty() && boost::filesystem::exists(file.str()))
             {
+                // Load once, the crop is rebuilt from it
+                pcl::io::loadPCDFile(file.str(), _groundCloud);
+                _groundWindow.setZero();
+            }
+            if(_groundCloud.empty())
+            {
+                // Same averaging as the live frames, on the whole sensor
+                nimbus::DepthFrame full;
+                _groundRays->update(sensor);
+                if(!full.fromCloud(sensor, _groundRays)) return false;
+                _groundQueue.enqueue(full);
+                if(_groundQueue.size() < 2) return false;
                 ROS_INFO("------------------ For the first time scan the empty table ---------------------");
                 ROS_INFO("------------------ If the table is not empty then please empty the table and RESTART ---------------------");
-                ros::Duration(1.0).sleep();
                 ROS_INFO("                   Saving ground truth.....");
-                pcl::io::savePCDFile(file.str(), *blob);
+                nimbus::DepthFrame meanFrame;
+                nimbus::meanDepth(_groundQueue, meanFrame, bands);
+                meanFrame.toCloud(_groundCloud);
+                pcl::io::savePCDFile(file.str(), _groundCloud);
+                _groundWindow.setZero();
                 ROS_INFO("                   Place the box");
                 return false;
             }
-            pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>());
-            typename pcl::PointCloud<pcl::PointXYZ>::Ptr ground (new pcl::PointCloud<pcl::PointXYZ>());
-            pcl::io::loadPCDFile(file.str(), *ground);
-            bool model = boxDectect->getBaseModel(ground, blob, height - 0.04, file.str(), *cloud);
-            if(!model) return false;
-            pcl::copyPointCloud(*cloud, res);
+            if(_groundCloud.width != sensor.width || _groundCloud.height != sensor.height)
+            {
+                ROS_WARN_THROTTLE(5, "Ground truth %s is %ux%u, the sensor %ux%u. Delete it to capture a new one",
+                                  file.str().c_str(), _groundCloud.width, _groundCloud.height, sensor.width, sensor.height);
+                return false;
+            }
+            if(_groundWindow != _window)
+            {
+                nimbus::SoAFrame cropped;
+                Eigen::Vector4i window;
+                cropFrame(_groundCloud, roi, cropped, window);
+                if(!cropped.toDepthFrame(_rays, _ground)) return false;
+                _groundWindow = window;
+                _groundTable.reset();
+            }
+            return boxDectect->getBaseModel(_ground, frame, height - 0.04, res);
+        }
+
+
+        /**
+         * Names of the blobs in the order of detected_poses from the cuboids of measureBlob.
+         * Ambiguous blobs are published on sku_ambiguous for the descriptor recognition, all others
+         * are settled by their size. blobNames and blobScores (SKU match confidence) are filled per blob.
+         */
+        void classifyBlobs(const PointCloud::Ptr &foreground, const BlobPoses &boxes, const ros::Time &stamp,
+                           std::vector<std::string> &blobNames, std::vector<float> &blobScores)
+        {
+            std_msgs::String names;
+            blobNames.clear();
+            blobScores.clear();
+            for(std::size_t b = 0; b < boxes.size(); ++b)
+            {
+                const float none = std::numeric_limits<float>::infinity();
+                nimbus::SkuMatch match = {-1, none, none, false};
+                if(boxes[b].fitted)
+                    match = skus.classify(boxes[b].cuboid.length, boxes[b].cuboid.width, boxes[b].cuboid.height);
+                if(b != 0) names.data += ",";
+                names.data += skus.name(match);
+                blobNames.push_back(skus.name(match));
+                blobScores.push_back(skus.score(match));
+                if(!match.ambiguous) continue;
+                PointCloud::Ptr blobCloud (new PointCloud());
+                segmentation.blobCloud(foreground, blobs[b], *blobCloud);
+                blobCloud->header.frame_id = "camera";
+                pcl_conversions::toPCL(stamp, blobCloud->header.stamp);
+                _pubAmbiguous.publish(blobCloud);
+            }
+            _pubSkus.publish(names);
+        }
+
+        /** Table plane of the active background model, NaN if there is none */
+        Eigen::Vector4f tablePlane()
+        {
+            const nimbus::TablePlane &table = background == "plane" ? _table : _groundTable;
+            if(background != "plane" && !_groundTable.valid() && _ground.size() != 0)
+            {
+                nimbus::SoAFrame ground;
+                ground.fromDepthFrame(_ground);
+                if(!_groundTable.fit(ground, bands)) ROS_WARN_ONCE("No table plane in the ground truth");
+            }
+            if(!table.valid()) return Eigen::Vector4f::Constant(std::numeric_limits<float>::quiet_NaN());
+            return table.plane();
+        }
+
+        /** Box marker, the TF is on the top face so the marker is shifted by half the height */
+        void publishMarker(const geometry_msgs::TransformStamped &box, double box_width, double box_length,
+                           double box_height = 0.001)
+        {
+            tf2::Quaternion q;
+            tf2::fromMsg(box.transform.rotation, q);
+            tf2::Vector3 offset = tf2::quatRotate(q, tf2::Vector3(0, 0, box_height / 2));
+            marker.header.stamp = box.header.stamp;
+            marker.pose.position.x = box.transform.translation.x + offset.x();
+            marker.pose.position.y = box.transform.translation.y + offset.y();
+            marker.pose.position.z = box.transform.translation.z + offset.z();
+            marker.pose.orientation = box.transform.rotation;
+            marker.scale.x = box_width;
+            marker.scale.y = box_length;
+            marker.scale.z = box_height;
+            _pubMarker.publish(marker);
+        }
+
+        /**
+         * Projects the workspace box into the sensor when the extrinsics, the box or the sensor
+         * layout changed. Returns false if the ROI is disabled (roi_size_* of 0) or unavailable.
+         */
+        bool updateROI(const PointCloud &blob)
+        {
+            if(roi_size_x <= 0 || roi_size_y <= 0 || roi_size_z <= 0) return false;
+            geometry_msgs::TransformStamped extrinsics;
+            try{
+                extrinsics = buffer.lookupTransform("camera", roi_frame, ros::Time(0));
+            }catch(tf2::TransformException &ex){
+                ROS_WARN_THROTTLE(5, "No workspace ROI, using the border crop: %s", ex.what());
+                return false;
+            }
+            const geometry_msgs::Quaternion &q = extrinsics.transform.rotation;
+            const geometry_msgs::Vector3 &t = extrinsics.transform.translation;
+            Eigen::Isometry3f baseToCamera = Eigen::Isometry3f::Identity();
+            baseToCamera.linear() = Eigen::Quaternionf(q.w, q.x, q.y, q.z).normalized().toRotationMatrix();
+            baseToCamera.translation() << t.x, t.y, t.z;
+            Eigen::Isometry3f box = Eigen::Isometry3f::Identity();
+            box.translation() << roi_x, roi_y, roi_z;
+            box.linear() = Eigen::AngleAxisf(roi_yaw, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+            const Eigen::Vector3f size(roi_size_x, roi_size_y, roi_size_z);
+
+            if(_roi.valid(blob.width, blob.height) && baseToCamera.isApprox(_roiExtrinsics, 1e-5f) &&
+               box.isApprox(_roiBox) && size.isApprox(_roiSize)) return true;
+            _sensorRays.update(blob);
+            _roi.setBox(box, size);
+            if(!_roi.update(baseToCamera, _sensorRays))
+            {
+                ROS_WARN_THROTTLE(5, "Workspace ROI is not visible to the camera");
+                return false;
+            }
+            _roiExtrinsics = baseToCamera;
+            _roiBox = box;
+            _roiSize = size;
+            ROS_INFO("Workspace ROI: %dx%d pixels at row %d col %d", _roi.windowWidth(), _roi.windowHeight(),
+                     _roi.rowBegin(), _roi.colBegin());
             return true;
         }
 
+        /** Detection on one frame, returns early if there is nothing to measure */
+        void process(const PointCloud::Ptr &blob, const ros::Time &frameStamp)
+        {
+            // Preprocessing runs on the planar frame, PCL points only for segmentation and publishing
+            const bool roi = updateROI(*blob);
+            Eigen::Vector4i window;
+            cropFrame(*blob, roi, _cropped, window);
+            if(window != _window)
+            {
+                // Frames of the old window would be averaged into the new one
+                nimbus::DepthFrame stale;
+                while(!_queue.isEmpty()) _queue.dequeue(stale);
+                // Learned rays never get overwritten, a moved window of the same size
+                // would reuse the rays of other sensor pixels
+                _rays.reset(new nimbus::RayTable());
+                _window = window;
+            }
+
+            nimbus::DepthFrame frame;
+            if(!_cropped.toDepthFrame(_rays, frame)) return;
+            _queue.enqueue(frame);
+            // Queue sheild
+            if(_queue.size() < 2) return;
+            
+            nimbus::DepthFrame meanFrame;
+            nimbus::meanDepth(_queue, meanFrame, bands);
+            
+            bool model = false;
+            if(background == "plane")
+            {
+                // Same height threshold as the reference capture, no file and no re-capture
+                _foreground.fromDepthFrame(meanFrame);
+                _table.setMargin(height - 0.04);
+                model = _table.foreground(_foreground, _tableMask, bands);
+                if(!model) ROS_WARN_THROTTLE(5, "No table plane found");
+                _foreground.valid = _tableMask;
+            }else{
+                model = groudTruth(*blob, meanFrame, roi, _foreground);
+            }
+            if(!model) return;
+            // Flying pixels at the box edges would become extreme corners
+            _foreground.valid.open(mask_opening);
+            PointCloud::Ptr foreground (new PointCloud());
+            _foreground.toCloud(*foreground);
+            //// Core Operation ////
+            segmentation.extractBlobs(foreground, blobs);
+            if(blobs.empty()){
+                ROS_WARN_THROTTLE(5, "No box on the table");
+                return;
+            }
+            const Eigen::Vector4f table = tablePlane();
+            BlobPoses boxes(blobs.size());
+            for(std::size_t b = 0; b < blobs.size(); ++b) measureBlob(foreground, b, table, boxes[b]);
+            std::vector<std::string> names;
+            std::vector<float> scores;
+            if(!skus.empty()) classifyBlobs(foreground, boxes, frameStamp, names, scores);
+            publishBlobs(boxes, names, scores, frameStamp);
+            // The track follows its box among all boxes, without a live track it starts on the largest one
+            std::size_t tracked = 0;
+            double closest = std::numeric_limits<double>::infinity();
+            for(std::size_t b = 0; b < boxes.size(); ++b)
+            {
+                const double d = tracker.distance(frameStamp.toSec(), boxes[b].position.cast<double>());
+                if(d < closest)
+                {
+                    closest = d;
+                    tracked = b;
+                }
+            }
+            if(boxes[tracked].yawValid)
+                tracker.update(frameStamp.toSec(), boxes[tracked].position.cast<double>(), boxes[tracked].yaw);
+            else
+                // Corner buffer is still averaging, the centroid is a valid measurement
+                tracker.update(frameStamp.toSec(), boxes[tracked].position.cast<double>());
+            // The largest box is published as TF
+            const BlobPose &box = boxes.front();
+            if(box.yawValid)
+            {
+                ROS_DEBUG("Yaw :%f", (box.yaw * 180)/M_PI );
+
+                // Sensor time of the frame, consumers extrapolate moving boxes from it
+                pose.header.stamp = frameStamp;
+                pose.transform.translation.x = box.position[0];
+                pose.transform.translation.y = box.position[1];
+                pose.transform.translation.z = box.position[2];
+                pose.transform.rotation.x = box.orientation.x();
+                pose.transform.rotation.y = box.orientation.y();
+                pose.transform.rotation.z = box.orientation.z();
+                pose.transform.rotation.w = box.orientation.w();
+                _pubPose.publish(pose);
+                broadCaster.sendTransform(pose);
+                if(box.measured && std::isfinite(box.height))
+                    publishMarker(pose, box.width, box.length, box.height);
+                else
+                    publishMarker(pose, box.width, box.length);
+            }
+
+            foreground->header.frame_id = "camera";
+            pcl_conversions::toPCL(frameStamp, foreground->header.stamp);
+            _pub.publish(foreground);
+        }
+
+        /** Smoothed pose of the tracked box at the time of the sensor frame */
+        void publishTracked(const ros::Time &frameStamp)
+        {
+            nimbus::BoxTracker::State state;
+            nimbus::BoxTracker::Covariance cov;
+            if(!tracker.predict(frameStamp.toSec(), state, cov)) return;
+
+            geometry_msgs::PoseWithCovarianceStamped tracked;
+            tracked.header.frame_id = "camera";
+            tracked.header.stamp = frameStamp;
+            tracked.pose.pose.position.x = state[0];
+            tracked.pose.pose.position.y = state[1];
+            tracked.pose.pose.position.z = state[2];
+            tf2::Quaternion q;
+            q.setRPY(0, 0, state[3]);
+            tracked.pose.pose.orientation = tf2::toMsg(q);
+            // Row major 6x6 (x, y, z, roll, pitch, yaw), roll and pitch are fixed to zero
+            const int idx[4] = {0, 1, 2, 5};
+            for(int r = 0; r < 4; ++r)
+                for(int c = 0; c < 4; ++c)
+                    tracked.pose.covariance[idx[r] * 6 + idx[c]] = cov(r, c);
+            _pubTracked.publish(tracked);
+        }
 
         void run()
         { 
@@ -163,61 +729,17 @@ class Detector{
                 {
                     _newCloud = false;
                     PointCloud::Ptr blob (new PointCloud());
-                    PointCloud::Ptr rCloud (new PointCloud());
-                    PointCloud::Ptr meanCloud (new PointCloud());
-                    PointCloud::Ptr cloud (new PointCloud());
 
                     std::unique_lock<std::mutex> lock(cloud_lock);
                     pcl::copyPointCloud(*_cloud, *blob);
                     lock.unlock();
-                    
-                    boxDectect->outlineRemover(blob, blob->width, blob->height, per_width, per_height, *rCloud);
-                    
-                    _queue.enqueue(*rCloud);
-                    // Queue sheild
-                    if(_queue.size() < 2) continue;
-                    
-                    boxDectect->meanFilter(_queue, *meanCloud);
-                    
-                    bool model = groudTruth(meanCloud, *cloud);
-                    if(!model) continue;
-                    //// Core Operation ////
-                    boxDectect->box3DCentroid(cloud, centroid);
-                    if(std::isnan(centroid[0])){
-                        ROS_ERROR ("Can not find the centroid");
-                        continue;
-                    }
-                    bool calYaw = boxDectect->boxYaw(cloud, width, length, centroid, yaw);
-                    ////////////////////////
-                    if(calYaw)
-                    {
-                        // Dump first few values of yaw make it stable
-                        // ToDo replace this loop burner
-                        // if(yawCounter <= 5)
-                        // {
-                        //     yawCounter += 1;
-                        //     continue;
-                        // }
-                        // yawCounter = 0;
-
-                        if((yaw * 180)/M_PI > 90) yaw = yaw - M_PI;
-                        if((yaw * 180)/M_PI < -90) yaw = yaw + M_PI;
-                        ROS_INFO("Yaw :%f", (yaw * 180)/M_PI );
-                        pose.header.stamp = ros::Time::now();
-                        pose.transform.translation.x = centroid[0];
-                        pose.transform.translation.y = centroid[1];
-                        pose.transform.translation.z = centroid[2];
-                        tf2::Quaternion q;
-                        // ToDo Orientation correction instead of -ve in x and y
-                        q.setRPY(0,0,yaw);
-                        pose.transform.rotation = tf2::toMsg(q);
-                        _pubPose.publish(pose);
-                        broadCaster.sendTransform(pose);
-                    }
-
-                    cloud->header.frame_id = "camera";
-                    pcl_conversions::toPCL(ros::Time::now(), cloud->header.stamp);
-                    _pub.publish(cloud);
+
+                    ros::Time frameStamp;
+                    pcl_conversions::fromPCL(blob->header.stamp, frameStamp);
+                    if(frameStamp.isZero()) frameStamp = ros::Time::now();
+
+                    process(blob, frameStamp);
+                    publishTracked(frameStamp);
                     ros::spinOnce();
                 }else{
                     ros::spinOnce();
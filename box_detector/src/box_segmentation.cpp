@@ -0,0 +1,198 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file box_segmentation.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <box_detector/box_segmentation.hpp>
+
+template class nimbus::BoxSegmentation<pcl::PointXYZ>;
+
+template <class PointType>
+nimbus::BoxSegmentation<PointType>::BoxSegmentation(float depth_jump, unsigned int min_points): _depthJump(depth_jump),
+                                                                                               _minPoints(min_points){}
+template <class PointType>
+nimbus::BoxSegmentation<PointType>::~BoxSegmentation(){}
+
+template <class PointType>
+int 
+nimbus::BoxSegmentation<PointType>::findRoot(int label)
+{
+    // Path halving
+    while(_parent[label] != label)
+    {
+        _parent[label] = _parent[_parent[label]];
+        label = _parent[label];
+    }
+    return label;
+}
+
+template <class PointType>
+void 
+nimbus::BoxSegmentation<PointType>::unite(int a, int b)
+{
+    a = findRoot(a);
+    b = findRoot(b);
+    if(a == b) return;
+    // Keep the smaller label as root, labels are created in raster order
+    if(a < b) _parent[b] = a;
+    else _parent[a] = b;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+unsigned int 
+nimbus::BoxSegmentation<PointType>::label(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob,
+                                          std::vector<int> &labels)
+{
+    const int width = blob->width;
+    const int height = blob->height;
+    labels.assign(blob->points.size(), -1);
+    if(height < 2 || static_cast<std::size_t>(width * height) != blob->points.size())
+        return 0;
+
+    _parent.clear();
+    for(int r = 0; r < height; ++r)
+    {
+        for(int c = 0; c < width; ++c)
+        {
+            const int i = r * width + c;
+            const PointType &point = blob->points[i];
+            if(!pcl::isFinite(point)) continue;
+
+            int left = -1, up = -1;
+            if(c > 0 && labels[i - 1] >= 0 &&
+               std::abs(blob->points[i - 1].z - point.z) < _depthJump)
+                left = labels[i - 1];
+            if(r > 0 && labels[i - width] >= 0 &&
+               std::abs(blob->points[i - width].z - point.z) < _depthJump)
+                up = labels[i - width];
+
+            if(left < 0 && up < 0)
+            {
+                labels[i] = static_cast<int>(_parent.size());
+                _parent.push_back(labels[i]);
+            }
+            else if(up < 0) labels[i] = left;
+            else if(left < 0) labels[i] = up;
+            else
+            {
+                labels[i] = left;
+                if(left != up) unite(left, up);
+            }
+        }
+    }
+
+    // Resolve the equivalences into compact label ids
+    std::vector<int> compact(_parent.size(), -1);
+    unsigned int count = 0;
+    for(std::size_t i = 0; i < labels.size(); ++i)
+    {
+        if(labels[i] < 0) continue;
+        int root = findRoot(labels[i]);
+        if(compact[root] < 0) compact[root] = count++;
+        labels[i] = compact[root];
+    }
+    return count;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+void 
+nimbus::BoxSegmentation<PointType>::extractBlobs(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob,
+                                                 BoxBlobs &blobs)
+{
+    blobs.clear();
+    std::vector<int> labels;
+    unsigned int count = this->label(blob, labels);
+    if(count == 0) return;
+
+    // Accumulate x, y, z and the second order moments per label in one pass
+    std::vector<Eigen::Matrix<float, 1, 9, Eigen::RowMajor>,
+                Eigen::aligned_allocator<Eigen::Matrix<float, 1, 9, Eigen::RowMajor> > > accu(count);
+    for(auto &a: accu) a.setZero();
+    BoxBlobs regions(count);
+    for(std::size_t i = 0; i < labels.size(); ++i)
+    {
+        if(labels[i] < 0) continue;
+        const PointType &point = blob->points[i];
+        Eigen::Matrix<float, 1, 9, Eigen::RowMajor> &a = accu[labels[i]];
+        a[0] += point.x * point.x;
+        a[1] += point.x * point.y;
+        a[2] += point.x * point.z;
+        a[3] += point.y * point.y;
+        a[4] += point.y * point.z;
+        a[5] += point.z * point.z;
+        a[6] += point.x;
+        a[7] += point.y;
+        a[8] += point.z;
+        regions[labels[i]].indices.push_back(static_cast<int>(i));
+    }
+
+    for(unsigned int l = 0; l < count; ++l)
+    {
+        BoxBlob &box = regions[l];
+        if(box.indices.size() < _minPoints) continue;
+        Eigen::Matrix<float, 1, 9, Eigen::RowMajor> a = accu[l] / static_cast<float>(box.indices.size());
+        box.centroid << a[6], a[7], a[8], 1;
+        box.covariance(0, 0) = a[0] - a[6] * a[6];
+        box.covariance(0, 1) = a[1] - a[6] * a[7];
+        box.covariance(0, 2) = a[2] - a[6] * a[8];
+        box.covariance(1, 1) = a[3] - a[7] * a[7];
+        box.covariance(1, 2) = a[4] - a[7] * a[8];
+        box.covariance(2, 2) = a[5] - a[8] * a[8];
+        box.covariance(1, 0) = box.covariance(0, 1);
+        box.covariance(2, 0) = box.covariance(0, 2);
+        box.covariance(2, 1) = box.covariance(1, 2);
+        // Major axis of the x-y covariance is the length side, the box y axis is along the length
+        float major = 0.5f * std::atan2(2 * box.covariance(0, 1), box.covariance(0, 0) - box.covariance(1, 1));
+        box.yaw = major - static_cast<float>(M_PI / 2);
+        if(box.yaw < -M_PI / 2) box.yaw += M_PI;
+        blobs.push_back(box);
+    }
+    std::sort(blobs.begin(), blobs.end(), [](const BoxBlob &a, const BoxBlob &b){
+        return a.indices.size() > b.indices.size();
+    });
+}
+
+template <class PointType>
+void 
+nimbus::BoxSegmentation<PointType>::blobCloud(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob,
+                                              const BoxBlob &box,
+                                              pcl::PointCloud<PointType> &res)
+{
+    PointType nan_point;
+    nan_point.x = nan_point.y = nan_point.z = std::numeric_limits<float>::quiet_NaN();
+    res.points.assign(blob->points.size(), nan_point);
+    for(int i: box.indices) res.points[i] = blob->points[i];
+    res.header = blob->header;
+    res.width = blob->width;
+    res.height = blob->height;
+    res.is_dense = false;
+    res.sensor_orientation_ = blob->sensor_orientation_;
+    res.sensor_origin_ = blob->sensor_origin_;
+}
@@ -0,0 +1,190 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file box_tracker.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <cmath>
+#include <limits>
+#include <Eigen/LU>
+#include <box_detector/box_tracker.hpp>
+
+nimbus::BoxTracker::BoxTracker(double q_pos, double q_yaw, double r_pos, double r_yaw, double timeout, double gate): _stamp(0),
+                                                                                                         _initialized(false),
+                                                                                                         _qPos(q_pos),
+                                                                                                         _qYaw(q_yaw),
+                                                                                                         _rPos(r_pos),
+                                                                                                         _rYaw(r_yaw),
+                                                                                                         _timeout(timeout),
+                                                                                                         _gate(gate)
+{
+    _x.setZero();
+    _P.setIdentity();
+}
+
+nimbus::BoxTracker::~BoxTracker(){}
+
+void 
+nimbus::BoxTracker::setNoise(double q_pos, double q_yaw, double r_pos, double r_yaw)
+{
+    _qPos = q_pos;
+    _qYaw = q_yaw;
+    _rPos = r_pos;
+    _rYaw = r_yaw;
+}
+
+double 
+nimbus::BoxTracker::wrapYaw(double yaw)
+{
+    yaw = std::fmod(yaw + M_PI / 2, M_PI);
+    if(yaw < 0) yaw += M_PI;
+    return yaw - M_PI / 2;
+}
+
+void 
+nimbus::BoxTracker::initialize(double stamp, const Eigen::Vector3d &position, double yaw, bool hasYaw)
+{
+    _x.setZero();
+    _x.head<3>() = position;
+    _x[3] = hasYaw ? wrapYaw(yaw) : 0;
+    _P.setZero();
+    _P.diagonal().head<3>().setConstant(_rPos * _rPos);
+    _P(3, 3) = hasYaw ? _rYaw * _rYaw : (M_PI / 2) * (M_PI / 2);
+    // Velocities are unknown, allow a moving conveyor
+    _P.diagonal().segment<3>(4).setConstant(0.5 * 0.5);
+    _P(7, 7) = 1.0;
+    _stamp = stamp;
+    _initialized = true;
+}
+
+void 
+nimbus::BoxTracker::propagate(double dt, State &x, Covariance &P) const
+{
+    if(dt <= 0) return;
+    Covariance F = Covariance::Identity();
+    F.block<4, 4>(0, 4).setIdentity();
+    F.block<4, 4>(0, 4) *= dt;
+
+    // Continuous white noise acceleration per axis
+    Covariance Q = Covariance::Zero();
+    const double dt2 = dt * dt / 2, dt3 = dt * dt * dt / 3;
+    for(int i = 0; i < 4; ++i)
+    {
+        double q = (i < 3) ? _qPos : _qYaw;
+        Q(i, i) = dt3 * q;
+        Q(i, i + 4) = Q(i + 4, i) = dt2 * q;
+        Q(i + 4, i + 4) = dt * q;
+    }
+    x = F * x;
+    x[3] = wrapYaw(x[3]);
+    P = F * P * F.transpose() + Q;
+}
+
+template <int M>
+bool 
+nimbus::BoxTracker::correct(const Eigen::Matrix<double, M, 1> &innovation,
+                            const Eigen::Matrix<double, M, 8> &H,
+                            const Eigen::Matrix<double, M, M> &R)
+{
+    Eigen::Matrix<double, M, M> S = H * _P * H.transpose() + R;
+    const Eigen::Matrix<double, M, M> Sinv = S.inverse();
+    if(_gate > 0 && innovation.dot(Sinv * innovation) > _gate) return false;
+    Eigen::Matrix<double, 8, M> K = _P * H.transpose() * Sinv;
+    _x += K * innovation;
+    _x[3] = wrapYaw(_x[3]);
+    // Joseph form keeps the covariance symmetric positive definite
+    Covariance IKH = Covariance::Identity() - K * H;
+    _P = IKH * _P * IKH.transpose() + K * R * K.transpose();
+    return true;
+}
+
+void 
+nimbus::BoxTracker::update(double stamp, const Eigen::Vector3d &position)
+{
+    if(!_initialized || stamp - _stamp > _timeout || stamp < _stamp)
+    {
+        initialize(stamp, position, 0, false);
+        return;
+    }
+    propagate(stamp - _stamp, _x, _P);
+
+    Eigen::Matrix<double, 3, 8> H = Eigen::Matrix<double, 3, 8>::Zero();
+    H.block<3, 3>(0, 0).setIdentity();
+    Eigen::Matrix<double, 3, 3> R = Eigen::Matrix<double, 3, 3>::Identity() * (_rPos * _rPos);
+    Eigen::Matrix<double, 3, 1> innovation = position - _x.head<3>();
+    if(!correct<3>(innovation, H, R))
+    {
+        // Another box, the tracked one left the view
+        initialize(stamp, position, 0, false);
+        return;
+    }
+    _stamp = stamp;
+}
+
+void 
+nimbus::BoxTracker::update(double stamp, const Eigen::Vector3d &position, double yaw)
+{
+    if(!_initialized || stamp - _stamp > _timeout || stamp < _stamp)
+    {
+        initialize(stamp, position, yaw, true);
+        return;
+    }
+    propagate(stamp - _stamp, _x, _P);
+
+    Eigen::Matrix<double, 4, 8> H = Eigen::Matrix<double, 4, 8>::Zero();
+    H.block<4, 4>(0, 0).setIdentity();
+    Eigen::Matrix<double, 4, 4> R = Eigen::Matrix<double, 4, 4>::Identity() * (_rPos * _rPos);
+    R(3, 3) = _rYaw * _rYaw;
+    Eigen::Matrix<double, 4, 1> innovation;
+    innovation.head<3>() = position - _x.head<3>();
+    innovation[3] = wrapYaw(yaw - _x[3]);
+    if(!correct<4>(innovation, H, R))
+    {
+        // Another box, the tracked one left the view
+        initialize(stamp, position, yaw, true);
+        return;
+    }
+    _stamp = stamp;
+}
+
+bool 
+nimbus::BoxTracker::predict(double stamp, State &state, Covariance &covariance) const
+{
+    if(!_initialized || stamp - _stamp > _timeout) return false;
+    state = _x;
+    covariance = _P;
+    propagate(stamp - _stamp, state, covariance);
+    return true;
+}
+
+double 
+nimbus::BoxTracker::distance(double stamp, const Eigen::Vector3d &position) const
+{
+    State x;
+    Covariance P;
+    if(!predict(stamp, x, P)) return std::numeric_limits<double>::infinity();
+    const Eigen::Vector3d innovation = position - x.head<3>();
+    const Eigen::Matrix3d S = P.topLeftCorner<3, 3>() + Eigen::Matrix3d::Identity() * (_rPos * _rPos);
+    return innovation.dot(S.inverse() * innovation);
+}
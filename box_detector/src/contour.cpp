@@ -0,0 +1,228 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file contour.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Geometry>
+#include <box_detector/contour.hpp>
+
+namespace
+{
+    // Clockwise from west in image coordinates (y down)
+    const int DX[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+    const int DY[8] = {0, -1, -1, -1, 0, 1, 1, 1};
+    const int BINS = 90;
+
+    inline int direction(int dx, int dy)
+    {
+        for(int d = 0; d < 8; ++d)
+            if(DX[d] == dx && DY[d] == dy) return d;
+        return 0;
+    }
+}
+
+void 
+nimbus::traceContour(const Bitmask &mask, std::vector<int> &contour)
+{
+    contour.clear();
+    const std::size_t first = mask.first();
+    if(first >= mask.size()) return;
+    const int w = mask.width(), h = mask.height();
+    const int sx = static_cast<int>(first % w), sy = static_cast<int>(first / w);
+    auto inside = [&](int x, int y){ return x >= 0 && y >= 0 && x < w && y < h && mask.test(y * w + x); };
+
+    // Raster order start, its west neighbour is background
+    int x = sx, y = sy, back = 0;
+    int secondX = -1, secondY = -1;
+    const std::size_t limit = 4 * mask.size() + 8;
+    for(std::size_t n = 0; n < limit; ++n)
+    {
+        contour.push_back(y * w + x);
+        int d = 1;
+        for(; d < 8; ++d)
+            if(inside(x + DX[(back + d) & 7], y + DY[(back + d) & 7])) break;
+        if(d == 8) return;      // Single pixel
+        const int k = (back + d) & 7;
+        // The last background pixel before the hit is the new backtrack position
+        const int bx = x + DX[(back + d - 1) & 7], by = y + DY[(back + d - 1) & 7];
+        const int nx = x + DX[k], ny = y + DY[k];
+        // Jacob's criterion: back at the start and about to repeat the first move
+        if(x == sx && y == sy && n != 0 && nx == secondX && ny == secondY)
+        {
+            contour.pop_back();
+            return;
+        }
+        if(n == 0)
+        {
+            secondX = nx;
+            secondY = ny;
+        }
+        back = direction(bx - nx, by - ny);
+        x = nx;
+        y = ny;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool 
+nimbus::dominantDirection(const std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f> > &outline,
+                          int step, float &angle, float &support)
+{
+    const int n = static_cast<int>(outline.size());
+    if(step < 1 || n < 2 * step) return false;
+    const float quarter = static_cast<float>(M_PI / 2);
+    float hough[BINS] = {0};
+    for(int i = 0; i < n; ++i)
+    {
+        const Eigen::Vector2f chord = outline[(i + step) % n] - outline[i];
+        float t = std::fmod(std::atan2(chord.y(), chord.x()), quarter);
+        if(t < 0) t += quarter;
+        hough[std::min(BINS - 1, static_cast<int>(t / quarter * BINS))] += chord.norm();
+    }
+    // Peak of the circularly smoothed accumulator
+    int peak = 0;
+    float best = -1;
+    for(int b = 0; b < BINS; ++b)
+    {
+        const float v = hough[(b + BINS - 1) % BINS] + hough[b] + hough[(b + 1) % BINS];
+        if(v > best){ best = v; peak = b; }
+    }
+    // Every point is assigned to the nearest side of the bounding rectangle along the
+    // current direction, corners are skipped. Each side is refit by total least squares
+    // so the pixel staircase averages out, twice to settle the assignment.
+    angle = (peak + 0.5f) * quarter / BINS;
+    for(int iteration = 0; iteration < 2; ++iteration)
+    {
+        const Eigen::Vector2f a(std::cos(angle), std::sin(angle)), b(-a.y(), a.x());
+        Eigen::Vector2f lo(outline[0].dot(a), outline[0].dot(b)), hi = lo;
+        for(const auto &p: outline)
+        {
+            const Eigen::Vector2f q(p.dot(a), p.dot(b));
+            lo = lo.cwiseMin(q);
+            hi = hi.cwiseMax(q);
+        }
+        const Eigen::Vector2f extent = hi - lo;
+        const float tolerance = 0.1f * extent.minCoeff();
+        Eigen::Vector2f mean[4];
+        Eigen::Matrix2f cov[4];
+        int count[4] = {0, 0, 0, 0};
+        for(int k = 0; k < 4; ++k)
+        {
+            mean[k].setZero();
+            cov[k].setZero();
+        }
+        std::vector<int> side(n, -1);
+        for(int i = 0; i < n; ++i)
+        {
+            const Eigen::Vector2f q(outline[i].dot(a), outline[i].dot(b));
+            const float d[4] = {q.x() - lo.x(), hi.x() - q.x(), q.y() - lo.y(), hi.y() - q.y()};
+            const int k = static_cast<int>(std::min_element(d, d + 4) - d);
+            // Near the side and away from both sides of the other family
+            const int o = k < 2 ? 2 : 0;
+            if(d[k] > tolerance || d[o] < 2 * tolerance || d[o + 1] < 2 * tolerance) continue;
+            side[i] = k;
+            mean[k] += outline[i];
+            ++count[k];
+        }
+        for(int i = 0; i < n; ++i)
+        {
+            if(side[i] < 0) continue;
+            const Eigen::Vector2f d = outline[i] - mean[side[i]] / count[side[i]];
+            cov[side[i]] += d * d.transpose();
+        }
+        float s = 0, c = 0;
+        int inlier = 0;
+        for(int k = 0; k < 4; ++k)
+        {
+            if(count[k] < step) continue;
+            const float phi = 0.5f * std::atan2(2 * cov[k](0, 1), cov[k](0, 0) - cov[k](1, 1));
+            // Averaged on the 4-fold angle so that the 90 deg wrap is seamless
+            s += count[k] * std::sin(4 * phi);
+            c += count[k] * std::cos(4 * phi);
+            inlier += count[k];
+        }
+        if(inlier == 0) return false;
+        angle = std::atan2(s, c) / 4;
+        if(angle < 0) angle += quarter;
+        support = static_cast<float>(inlier) / n;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool 
+nimbus::contourYaw(const SoAFrame &frame, const Bitmask &mask, const Eigen::Vector3f &normal,
+                   float &yaw, float &length, float &width, float &support)
+{
+    // Plane basis, u follows the camera x axis like boxYawMinAreaRect
+    const Eigen::Vector3f n = normal.normalized();
+    Eigen::Vector3f u = Eigen::Vector3f::UnitX() - n * n.x();
+    if(u.norm() < 1e-3f) u = Eigen::Vector3f::UnitY() - n * n.y();
+    u.normalize();
+    const Eigen::Vector3f v = n.cross(u);
+
+    Bitmask region = frame.valid;
+    region &= mask;
+    std::vector<int> contour;
+    traceContour(region, contour);
+    std::vector<Eigen::Vector2f, Eigen::aligned_allocator<Eigen::Vector2f> > outline;
+    outline.reserve(contour.size());
+    for(int i: contour)
+    {
+        const Eigen::Vector3f p(frame.x[i], frame.y[i], frame.z[i]);
+        outline.push_back(Eigen::Vector2f(u.dot(p), v.dot(p)));
+    }
+    // About 5 % of the perimeter per chord, at least 3 pixels
+    const int step = std::max(3, static_cast<int>(outline.size() / 20));
+    float angle;
+    if(!dominantDirection(outline, step, angle, support)) return false;
+
+    const Eigen::Vector2f a(std::cos(angle), std::sin(angle)), b(-a.y(), a.x());
+    float minA = outline[0].dot(a), maxA = minA, minB = outline[0].dot(b), maxB = minB;
+    for(const auto &p: outline)
+    {
+        minA = std::min(minA, p.dot(a));
+        maxA = std::max(maxA, p.dot(a));
+        minB = std::min(minB, p.dot(b));
+        maxB = std::max(maxB, p.dot(b));
+    }
+    float lengthAngle = angle;
+    length = maxA - minA;
+    width = maxB - minB;
+    if(width > length)
+    {
+        std::swap(length, width);
+        lengthAngle += static_cast<float>(M_PI / 2);
+    }
+    // Box y axis is along the length side
+    yaw = lengthAngle - static_cast<float>(M_PI / 2);
+    if(yaw < -M_PI / 2) yaw += M_PI;
+    if(yaw >= M_PI / 2) yaw -= M_PI;
+    return true;
+}
@@ -0,0 +1,105 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file cuboid.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <box_detector/cuboid.hpp>
+#include <box_detector/min_area_rect.hpp>
+
+bool 
+nimbus::estimateCuboid(const SoAFrame &frame, const Bitmask &mask, const Eigen::Vector4f &topPlane,
+                       const Eigen::Vector4f &table, float inlierDistance, Cuboid &res)
+{
+    const Eigen::Vector3f n = topPlane.head<3>();
+    const Eigen::Vector3f zAxis = -n;
+    // Plane basis, u follows the camera x axis like boxYawMinAreaRect
+    Eigen::Vector3f u = Eigen::Vector3f::UnitX() - zAxis * zAxis.x();
+    if(u.norm() < 1e-3f) u = Eigen::Vector3f::UnitY() - zAxis * zAxis.y();
+    u.normalize();
+    const Eigen::Vector3f v = zAxis.cross(u);
+
+    Bitmask selection = frame.valid;
+    selection &= mask;
+    std::size_t points = 0;
+    std::vector<Eigen::Vector2f> face;
+    selection.forEach([&](std::size_t i){
+        ++points;
+        const Eigen::Vector3f p(frame.x[i], frame.y[i], frame.z[i]);
+        if(std::abs(n.dot(p) + topPlane[3]) > inlierDistance) return;
+        face.push_back(Eigen::Vector2f(u.dot(p), v.dot(p)));
+    });
+    std::vector<Eigen::Vector2f> hull;
+    convexHull(face, hull);
+    RotatedRect rect;
+    if(!minAreaRect(hull, rect)) return false;
+
+    // Length side in 3D, x completes the right handed frame. The box is symmetric, x is
+    // turned towards the camera x axis so that yaw stays within +-90 deg like boxYaw
+    Eigen::Vector3f yAxis = (std::cos(rect.yaw) * u + std::sin(rect.yaw) * v).normalized();
+    Eigen::Vector3f xAxis = yAxis.cross(zAxis);
+    if(xAxis.dot(u) < 0)
+    {
+        xAxis = -xAxis;
+        yAxis = -yAxis;
+    }
+    Eigen::Matrix3f R;
+    R << xAxis, yAxis, zAxis;
+    res.orientation = Eigen::Quaternionf(R);
+    res.length = rect.length;
+    res.width = rect.width;
+    res.yaw = std::atan2(xAxis.dot(v), xAxis.dot(u));
+    // Rectangle center lifted back onto the top plane
+    res.topCenter = rect.center.x() * u + rect.center.y() * v - topPlane[3] * n;
+
+    const bool hasTable = table.allFinite();
+    if(hasTable)
+    {
+        const float distance = std::abs(table.head<3>().dot(res.topCenter) + table[3]);
+        res.height = distance;
+        res.center = res.topCenter + zAxis * (distance / 2);
+        res.tilt = std::acos(std::min(1.0f, std::abs(n.dot(table.head<3>()))));
+    }else{
+        res.height = std::numeric_limits<float>::quiet_NaN();
+        res.center = res.topCenter;
+        res.tilt = std::acos(std::min(1.0f, std::abs(n.z())));
+    }
+
+    // Shoelace area of the hull, a clean top face fills its rectangle
+    float hullArea = 0;
+    for(std::size_t i = 0; i < hull.size(); ++i)
+    {
+        const Eigen::Vector2f &a = hull[i], &b = hull[(i + 1) % hull.size()];
+        hullArea += a.x() * b.y() - b.x() * a.y();
+    }
+    hullArea = std::abs(hullArea) / 2;
+    const float fill = rect.area > 0 ? std::min(1.0f, hullArea / rect.area) : 0.0f;
+    const float support = points > 0 ? static_cast<float>(face.size()) / points : 0.0f;
+    res.quality = fill * support;
+    return true;
+}
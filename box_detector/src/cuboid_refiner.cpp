@@ -0,0 +1,187 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file cuboid_refiner.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <cmath>
+#include <Eigen/Geometry>
+#include <box_detector/cuboid_refiner.hpp>
+
+nimbus::CuboidRefiner::CuboidRefiner(int maxIterations, float outlierDistance, float huber, float damping):
+    _maxIterations(maxIterations),
+    _outlierDistance(outlierDistance),
+    _huber(huber),
+    _damping(damping),
+    _iterations(0),
+    _converged(false),
+    _inliers(0),
+    _rms(0)
+{
+}
+
+nimbus::CuboidRefiner::~CuboidRefiner()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void 
+nimbus::CuboidRefiner::setParameter(int maxIterations, float outlierDistance, float huber, float damping)
+{
+    _maxIterations = maxIterations;
+    _outlierDistance = outlierDistance;
+    _huber = huber;
+    _damping = damping;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool 
+nimbus::CuboidRefiner::refine(const SoAFrame &frame, const Bitmask &roi, Cuboid &cuboid)
+{
+    _iterations = 0;
+    _converged = false;
+    _inliers = 0;
+    if(!std::isfinite(cuboid.height) || cuboid.height <= 0) return false;
+
+    Bitmask selection = frame.valid;
+    selection &= roi;
+    const Eigen::Index n = static_cast<Eigen::Index>(selection.count());
+    _dx.resize(n);
+    _dy.resize(n);
+    _dz.resize(n);
+    _range.resize(n);
+    Eigen::Index k = 0;
+    selection.forEach([&](std::size_t i){
+        const float r = std::sqrt(frame.x[i] * frame.x[i] + frame.y[i] * frame.y[i] + frame.z[i] * frame.z[i]);
+        _range[k] = r;
+        _dx[k] = frame.x[i] / r;
+        _dy[k] = frame.y[i] / r;
+        _dz[k] = frame.z[i] / r;
+        ++k;
+    });
+    if(n < 6) return false;
+
+    Eigen::Matrix3f R = cuboid.orientation.toRotationMatrix();
+    Eigen::Vector3f c = cuboid.center;
+    // Cuboid axes: x width, y length, z height
+    const Eigen::Vector3f half(cuboid.width / 2, cuboid.length / 2, cuboid.height / 2);
+    // Work arrays are kept between calls, the loop does not allocate
+    _work.resize(n, WORK_COLUMNS);
+    _J.resize(n, 6);
+    _e.resize(n);
+    _w.resize(n);
+    auto lx = _work.col(0), ly = _work.col(1), lz = _work.col(2);
+    auto ix = _work.col(3), iy = _work.col(4), iz = _work.col(5);
+    auto ex = _work.col(6), ey = _work.col(7), ez = _work.col(8);
+    auto t = _work.col(9), tFar = _work.col(10), a = _work.col(11);
+    auto kx = _work.col(12), ky = _work.col(13), kz = _work.col(14), scale = _work.col(15);
+    for(int it = 0; it < _maxIterations; ++it)
+    {
+        // Rays and camera origin in the box frame
+        const Eigen::Matrix3f Rt = R.transpose();
+        const Eigen::Vector3f o = -(Rt * c);
+        lx = Rt(0, 0) * _dx + Rt(0, 1) * _dy + Rt(0, 2) * _dz;
+        ly = Rt(1, 0) * _dx + Rt(1, 1) * _dy + Rt(1, 2) * _dz;
+        lz = Rt(2, 0) * _dx + Rt(2, 1) * _dy + Rt(2, 2) * _dz;
+        // Slab test, the entering face is the axis with the latest entry
+        ix = lx.inverse();
+        iy = ly.inverse();
+        iz = lz.inverse();
+        ex = ((-half.x() - o.x()) * ix).min((half.x() - o.x()) * ix);
+        ey = ((-half.y() - o.y()) * iy).min((half.y() - o.y()) * iy);
+        ez = ((-half.z() - o.z()) * iz).min((half.z() - o.z()) * iz);
+        t = ex.max(ey).max(ez);
+        tFar = ((-half.x() - o.x()) * ix).max((half.x() - o.x()) * ix)
+               .min(((-half.y() - o.y()) * iy).max((half.y() - o.y()) * iy))
+               .min(((-half.z() - o.z()) * iz).max((half.z() - o.z()) * iz));
+        // One hot entering axis without boolean arrays: t - e is exactly zero for the winner
+        kx = lx * (1.0f - ((t - ex) * 1e6f).min(1.0f));
+        ky = ly * (1.0f - ((t - ey) * 1e6f).min(1.0f));
+        kz = lz * (1.0f - ((t - ez) * 1e6f).min(1.0f));
+        // |l| of the entering axis, the outward face normal is -k / a and n.d = -a
+        a = kx.abs() + ky.abs() + kz.abs();
+
+        // Residual and square root of the Huber weight, vectorized for every ray
+        _e = _range - t;
+        _w = (_huber / _e.abs().max(_huber)).sqrt();
+        scale = _w / (a * a);
+        // Misses, outliers and grazing rays get zero weight, their slab values may be NaN
+        _inliers = 0;
+        for(Eigen::Index k = 0; k < n; ++k)
+        {
+            const bool hit = t[k] <= tFar[k] && t[k] > 0 && std::abs(_e[k]) < _outlierDistance && a[k] > 1e-3f;
+            _e[k] = hit ? _e[k] : 0.0f;
+            _w[k] = hit ? _w[k] : 0.0f;
+            t[k] = hit ? t[k] : 0.0f;
+            scale[k] = hit ? scale[k] : 0.0f;
+            _inliers += hit;
+        }
+        if(_inliers < 6) return false;
+        _rms = std::sqrt(_e.square().sum() / _inliers);
+
+        // dt/dc = n / (n.d) = m / a^2 and dt/dw = m x (c - t d) / a^2 with m = R k,
+        // rotation about the box center. The slab columns are reused.
+        auto mx = _work.col(3), my = _work.col(4), mz = _work.col(5);
+        auto cx = _work.col(6), cy = _work.col(7), cz = _work.col(8);
+        mx = R(0, 0) * kx + R(0, 1) * ky + R(0, 2) * kz;
+        my = R(1, 0) * kx + R(1, 1) * ky + R(1, 2) * kz;
+        mz = R(2, 0) * kx + R(2, 1) * ky + R(2, 2) * kz;
+        cx = c.x() - t * _dx;
+        cy = c.y() - t * _dy;
+        cz = c.z() - t * _dz;
+        _J.col(0) = (scale * mx).matrix();
+        _J.col(1) = (scale * my).matrix();
+        _J.col(2) = (scale * mz).matrix();
+        _J.col(3) = (scale * (my * cz - mz * cy)).matrix();
+        _J.col(4) = (scale * (mz * cx - mx * cz)).matrix();
+        _J.col(5) = (scale * (mx * cy - my * cx)).matrix();
+        _e *= _w;
+        // Column dot products, much faster than a general product for a tall 6 column matrix
+        Eigen::Matrix<float, 6, 6> H;
+        Eigen::Matrix<float, 6, 1> g;
+        for(int i = 0; i < 6; ++i)
+        {
+            g[i] = _J.col(i).dot(_e.matrix());
+            for(int j = i; j < 6; ++j) H(i, j) = H(j, i) = _J.col(i).dot(_J.col(j));
+        }
+        H.diagonal().array() += _damping * H.trace() / 6 + 1e-9f;
+        const Eigen::Matrix<float, 6, 1> delta = H.ldlt().solve(g);
+        if(!delta.allFinite()) return false;
+        c += delta.head<3>();
+        const Eigen::Vector3f omega = delta.tail<3>();
+        if(omega.norm() > 0) R = Eigen::AngleAxisf(omega.norm(), omega.normalized()).toRotationMatrix() * R;
+        ++_iterations;
+        if(delta.head<3>().norm() < 1e-5f && omega.norm() < 1e-5f)
+        {
+            _converged = true;
+            break;
+        }
+    }
+    cuboid.center = c;
+    cuboid.orientation = Eigen::Quaternionf(R);
+    cuboid.topCenter = c - R.col(2) * half.z();
+    return true;
+}
@@ -0,0 +1,126 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file depth_frame.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <box_detector/depth_frame.hpp>
+
+constexpr float nimbus::DepthFrame::DEFAULT_SCALE;
+
+nimbus::RayTable::RayTable(): _width(0), _height(0), _unknown(0){}
+nimbus::RayTable::~RayTable(){}
+
+void 
+nimbus::RayTable::reset(int width, int height)
+{
+    _width = width;
+    _height = height;
+    _unknown = static_cast<std::size_t>(width) * height;
+    _rayX.assign(_unknown, std::numeric_limits<float>::quiet_NaN());
+    _rayY.assign(_unknown, std::numeric_limits<float>::quiet_NaN());
+}
+
+nimbus::DepthFrame::DepthFrame(): _width(0), _height(0), _scale(DEFAULT_SCALE){}
+nimbus::DepthFrame::~DepthFrame(){}
+
+void 
+nimbus::DepthFrame::reset(int width, int height, const RayTable::ConstPtr &rays, float scale)
+{
+    _width = width;
+    _height = height;
+    _scale = scale;
+    _rays = rays;
+    _depth.assign(static_cast<std::size_t>(width) * height, 0);
+    _amplitude.assign(_depth.size(), 0);
+}
+
+std::uint16_t 
+nimbus::DepthFrame::quantize(float depth) const
+{
+    const float q = depth / _scale + 0.5f;
+    if(!(q >= 1.0f) || q > std::numeric_limits<std::uint16_t>::max()) return 0;
+    return static_cast<std::uint16_t>(q);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void 
+nimbus::DepthFrame::points(const std::vector<int> &indices, Eigen::Matrix3Xf &xyz) const
+{
+    const Eigen::Index n = static_cast<Eigen::Index>(indices.size());
+    Eigen::ArrayXf z(n), rx(n), ry(n);
+    for(Eigen::Index k = 0; k < n; ++k)
+    {
+        const int i = indices[k];
+        z[k] = _depth[i];
+        rx[k] = _rays->rayX(i);
+        ry[k] = _rays->rayY(i);
+    }
+    z *= _scale;
+    xyz.resize(3, n);
+    xyz.row(0) = (z * rx).matrix().transpose();
+    xyz.row(1) = (z * ry).matrix().transpose();
+    xyz.row(2) = z.matrix().transpose();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool 
+nimbus::meanDepth(pcl::SynchronizedQueue<DepthFrame> &queue, DepthFrame &res, const RowBands &config)
+{
+    if(queue.isEmpty()) return false;
+    std::vector<DepthFrame> frames(1);
+    queue.dequeue(frames.front());
+    const std::size_t size = frames.front().size();
+    const std::size_t width = frames.front().width(), height = frames.front().height();
+    res.reset(width, height, frames.front().rays(), frames.front().scale());
+    res.header = frames.front().header;
+    while(!queue.isEmpty())
+    {
+        DepthFrame frame;
+        queue.dequeue(frame);
+        // Frames of another layout (sensor mode change) are dropped
+        if(frame.size() != size) continue;
+        res.header = frame.header;
+        frames.push_back(frame);
+    }
+    parallelRows(height, width, config, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t i = begin * width; i < end * width; ++i)
+        {
+            std::uint32_t depthSum = 0, amplitudeSum = 0, count = 0;
+            for(const auto &frame: frames)
+            {
+                if(!frame.isValid(i)) continue;
+                depthSum += frame.rawDepth(i);
+                amplitudeSum += static_cast<std::uint32_t>(frame.amplitude(i));
+                ++count;
+            }
+            if(count == 0) continue;
+            const std::uint32_t half = count / 2;
+            res.setRaw(i, static_cast<std::uint16_t>((depthSum + half) / count),
+                          static_cast<std::uint16_t>((amplitudeSum + half) / count));
+        }
+    });
+    return true;
+}
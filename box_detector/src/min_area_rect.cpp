@@ -0,0 +1,131 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file min_area_rect.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <box_detector/min_area_rect.hpp>
+
+namespace
+{
+    inline float cross(const Eigen::Vector2f &o, const Eigen::Vector2f &a, const Eigen::Vector2f &b)
+    {
+        return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+    }
+}
+
+void 
+nimbus::convexHull(std::vector<Eigen::Vector2f> points, std::vector<Eigen::Vector2f> &hull)
+{
+    hull.clear();
+    if(points.size() < 3)
+    {
+        hull = points;
+        return;
+    }
+    std::sort(points.begin(), points.end(), [](const Eigen::Vector2f &a, const Eigen::Vector2f &b){
+        return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+    });
+
+    hull.resize(2 * points.size());
+    std::size_t k = 0;
+    // Lower hull
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+        while(k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) --k;
+        hull[k++] = points[i];
+    }
+    // Upper hull
+    for(std::size_t i = points.size() - 1, t = k + 1; i > 0; --i)
+    {
+        while(k >= t && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0) --k;
+        hull[k++] = points[i - 1];
+    }
+    // Last point is equal to the first one
+    hull.resize(k - 1);
+}
+
+bool 
+nimbus::minAreaRect(const std::vector<Eigen::Vector2f> &hull, RotatedRect &rect)
+{
+    const std::size_t n = hull.size();
+    if(n < 3) return false;
+
+    rect.area = std::numeric_limits<float>::max();
+    // Caliper pointers: r max along edge, l min along edge, u max along inner normal
+    std::size_t r = 0, l = 0, u = 0;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        const Eigen::Vector2f &p = hull[i];
+        Eigen::Vector2f e = (hull[(i + 1) % n] - p).normalized();
+        Eigen::Vector2f nrm(-e.y(), e.x());
+
+        if(i == 0)
+        {
+            for(std::size_t j = 1; j < n; ++j)
+            {
+                if(hull[j].dot(e) > hull[r].dot(e)) r = j;
+                if(hull[j].dot(e) < hull[l].dot(e)) l = j;
+                if(hull[j].dot(nrm) > hull[u].dot(nrm)) u = j;
+            }
+        }
+        else
+        {
+            // The extreme points only move forward while the edge rotates counter clockwise
+            while(hull[(r + 1) % n].dot(e) > hull[r].dot(e)) r = (r + 1) % n;
+            while(hull[(u + 1) % n].dot(nrm) > hull[u].dot(nrm)) u = (u + 1) % n;
+            while(hull[(l + 1) % n].dot(e) < hull[l].dot(e)) l = (l + 1) % n;
+        }
+
+        float minE = (hull[l] - p).dot(e);
+        float maxE = (hull[r] - p).dot(e);
+        float height = (hull[u] - p).dot(nrm);
+        float side = maxE - minE;
+        float area = side * height;
+        if(area < rect.area)
+        {
+            rect.area = area;
+            rect.center = p + e * (0.5f * (minE + maxE)) + nrm * (0.5f * height);
+            if(side >= height)
+            {
+                rect.length = side;
+                rect.width = height;
+                rect.yaw = std::atan2(e.y(), e.x());
+            }
+            else
+            {
+                rect.length = height;
+                rect.width = side;
+                rect.yaw = std::atan2(nrm.y(), nrm.x());
+            }
+        }
+    }
+    // Rectangle is symmetric, keep the yaw within [-pi/2, pi/2)
+    if(rect.yaw >= M_PI / 2) rect.yaw -= M_PI;
+    if(rect.yaw < -M_PI / 2) rect.yaw += M_PI;
+    return true;
+}
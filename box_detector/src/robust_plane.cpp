@@ -0,0 +1,162 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file robust_plane.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <box_detector/robust_plane.hpp>
+
+nimbus::RobustPlane::RobustPlane(float threshold, float confidence, int maxIterations,
+                                 std::size_t maxPoints, unsigned int seed, PlaneEstimator estimator):
+    _seed(seed), _iterations(0), _inliers(0)
+{
+    setParameter(threshold, confidence, maxIterations, maxPoints, estimator);
+}
+nimbus::RobustPlane::~RobustPlane(){}
+
+void 
+nimbus::RobustPlane::setParameter(float threshold, float confidence, int maxIterations,
+                                  std::size_t maxPoints, PlaneEstimator estimator)
+{
+    _threshold = threshold;
+    _confidence = std::min(std::max(confidence, 0.5f), 0.9999f);
+    _maxIterations = std::max(maxIterations, 1);
+    _maxPoints = maxPoints;
+    _estimator = estimator;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool 
+nimbus::RobustPlane::samplePlane(Eigen::Vector4f &plane)
+{
+    std::uniform_int_distribution<int> pick(0, static_cast<int>(_x.size()) - 1);
+    const int i = pick(_random), j = pick(_random), k = pick(_random);
+    if(i == j || j == k || i == k) return false;
+    const Eigen::Vector3f p0(_x[i], _y[i], _z[i]);
+    const Eigen::Vector3f normal = (Eigen::Vector3f(_x[j], _y[j], _z[j]) - p0).cross(Eigen::Vector3f(_x[k], _y[k], _z[k]) - p0);
+    const float norm = normal.norm();
+    if(norm < 1e-9f) return false;
+    plane << normal / norm, -normal.dot(p0) / norm;
+    return true;
+}
+
+bool 
+nimbus::RobustPlane::refit(float threshold, Eigen::Vector4f &plane, float &curvature)
+{
+    _residual = (plane[0] * _x + plane[1] * _y + plane[2] * _z + plane[3]).abs();
+    PointMoments moments(_x[0], _y[0], _z[0]);
+    for(Eigen::Index i = 0; i < _x.size(); ++i)
+        if(_residual[i] <= threshold) moments.add(_x[i], _y[i], _z[i]);
+    if(moments.n < 3) return false;
+    Eigen::Vector4f centroid;
+    Eigen::Matrix3f covariance;
+    moments.get(centroid, covariance);
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(covariance);
+    const Eigen::Vector3f normal = solver.eigenvectors().col(0);
+    plane << normal, -normal.dot(centroid.head<3>());
+    const float sum = solver.eigenvalues().sum();
+    curvature = sum > 0 ? std::abs(solver.eigenvalues()[0] / sum) : 0.0f;
+    _inliers = static_cast<std::size_t>(moments.n);
+    return true;
+}
+
+bool 
+nimbus::RobustPlane::fit(const SoAFrame &frame, const Bitmask &mask, Eigen::Vector4f &plane, float &curvature)
+{
+    _iterations = 0;
+    _inliers = 0;
+    plane.setConstant(std::numeric_limits<float>::quiet_NaN());
+    curvature = std::numeric_limits<float>::quiet_NaN();
+    Bitmask selection = frame.valid;
+    selection &= mask;
+    const std::size_t points = selection.count();
+    if(points < 3) return false;
+
+    // Compact planes of the selected pixels, evenly subsampled
+    const std::size_t stride = (_maxPoints > 0 && points > _maxPoints) ? (points + _maxPoints - 1) / _maxPoints : 1;
+    const std::size_t size = (points + stride - 1) / stride;
+    _x.resize(size);
+    _y.resize(size);
+    _z.resize(size);
+    std::size_t n = 0, k = 0;
+    selection.forEach([&](std::size_t i){
+        if(k++ % stride != 0) return;
+        _x[n] = frame.x[i];
+        _y[n] = frame.y[i];
+        _z[n] = frame.z[i];
+        ++n;
+    });
+
+    _random.seed(_seed);
+    const double logFailure = std::log(1.0 - _confidence);
+    // LMedS has no inlier ratio to adapt to, assume half of the points are outliers
+    int required = (_estimator == PlaneEstimator::LMEDS) ?
+        std::min(_maxIterations, static_cast<int>(std::ceil(logFailure / std::log(1.0 - 0.125)))) : _maxIterations;
+    Eigen::Vector4f best = Eigen::Vector4f::Zero(), candidate;
+    float bestScore = (_estimator == PlaneEstimator::LMEDS) ? std::numeric_limits<float>::max() : -1.0f;
+    int draws = 0;
+    while(_iterations < required && draws < 4 * _maxIterations)
+    {
+        ++draws;
+        if(!samplePlane(candidate)) continue;
+        ++_iterations;
+        _residual = (candidate[0] * _x + candidate[1] * _y + candidate[2] * _z + candidate[3]).abs();
+        if(_estimator == PlaneEstimator::RANSAC)
+        {
+            const float score = static_cast<float>((_residual <= _threshold).count());
+            if(score <= bestScore) continue;
+            bestScore = score;
+            best = candidate;
+            // Adaptive termination: samples needed for an outlier free draw at this inlier ratio
+            const double ratio = score / static_cast<double>(size);
+            const double allInliers = ratio * ratio * ratio;
+            if(allInliers >= 1.0 - 1e-9) break;
+            required = std::min(_maxIterations, static_cast<int>(std::ceil(logFailure / std::log(1.0 - allInliers))));
+        }else{
+            _sorted.assign(_residual.data(), _residual.data() + size);
+            std::nth_element(_sorted.begin(), _sorted.begin() + size / 2, _sorted.end());
+            const float median = _sorted[size / 2];
+            if(median < bestScore)
+            {
+                bestScore = median;
+                best = candidate;
+            }
+        }
+    }
+    if(bestScore < 0 || _iterations == 0) return false;
+
+    // Refit threshold of LMedS from the robust standard deviation of the best sample
+    float threshold = _threshold;
+    if(_estimator == PlaneEstimator::LMEDS)
+        threshold = std::max(2.5f * 1.4826f * (1.0f + 5.0f / std::max<float>(size - 3, 1)) * bestScore, 1e-4f);
+    plane = best;
+    if(!refit(threshold, plane, curvature)) return false;
+    // A second pass with the refit plane picks up the points the sample plane just missed
+    refit(threshold, plane, curvature);
+    // Normal towards the camera at the origin
+    if(plane[3] < 0) plane = -plane;
+    return true;
+}
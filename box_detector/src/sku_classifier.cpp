@@ -0,0 +1,102 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file sku_classifier.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <box_detector/sku_classifier.hpp>
+
+nimbus::SkuClassifier::SkuClassifier(float margin): _margin(margin)
+{
+}
+
+nimbus::SkuClassifier::~SkuClassifier()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool 
+nimbus::SkuClassifier::add(const Sku &sku)
+{
+    // Distances are in tolerances
+    if(!(sku.tolerance > 0)) return false;
+    Sku s = sku;
+    if(s.width > s.length) std::swap(s.width, s.length);
+    _skus.push_back(s);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+nimbus::SkuMatch 
+nimbus::SkuClassifier::classify(float length, float width, float height) const
+{
+    if(width > length) std::swap(width, length);
+    SkuMatch res = {-1, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), false};
+    float second = std::numeric_limits<float>::infinity();
+    for(std::size_t i = 0; i < _skus.size(); ++i)
+    {
+        const Sku &s = _skus[i];
+        float d = std::max(std::abs(length - s.length), std::abs(width - s.width));
+        if(s.height > 0 && std::isfinite(height)) d = std::max(d, std::abs(height - s.height));
+        d /= s.tolerance;
+        if(d > 1) continue;
+        if(d < res.distance)
+        {
+            second = res.distance;
+            res.distance = d;
+            res.index = static_cast<int>(i);
+        }else if(d < second){
+            second = d;
+        }
+    }
+    res.gap = second - res.distance;
+    res.ambiguous = res.index >= 0 && res.gap < _margin;
+    return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float 
+nimbus::SkuClassifier::score(const SkuMatch &match) const
+{
+    if(match.index < 0) return 0;
+    float score = 1 - match.distance;
+    if(match.ambiguous) score *= _margin > 0 ? match.gap / _margin : 0;
+    return std::max(0.0f, std::min(1.0f, score));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string 
+nimbus::SkuClassifier::name(const SkuMatch &match) const
+{
+    if(match.index < 0) return "unknown";
+    if(match.ambiguous) return "ambiguous";
+    return _skus[match.index].name;
+}
@@ -0,0 +1,165 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file soa_frame.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <box_detector/soa_frame.hpp>
+
+nimbus::SoAFrame::SoAFrame(): _width(0), _height(0){}
+nimbus::SoAFrame::~SoAFrame(){}
+
+void 
+nimbus::SoAFrame::reset(int width, int height)
+{
+    _width = width;
+    _height = height;
+    const std::size_t size = static_cast<std::size_t>(width) * height;
+    x.assign(size, 0.0f);
+    y.assign(size, 0.0f);
+    z.assign(size, 0.0f);
+    intensity.assign(size, 0.0f);
+    valid.reset(width, height);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void 
+nimbus::SoAFrame::fromDepthFrame(const DepthFrame &frame)
+{
+    reset(frame.width(), frame.height());
+    header = frame.header;
+    if(!frame.rays()) return;
+    const RayTable &rays = *frame.rays();
+    const float scale = frame.scale();
+    for(std::size_t i = 0; i < size(); ++i)
+    {
+        // Branch free, the mask decides
+        const float depth = frame.rawDepth(i) * scale;
+        x[i] = depth * rays.rayX(i);
+        y[i] = depth * rays.rayY(i);
+        z[i] = depth;
+        intensity[i] = frame.amplitude(i);
+    }
+    for(std::size_t i = 0; i < size(); ++i)
+        if(frame.isValid(i)) valid.set(i);
+}
+
+bool 
+nimbus::SoAFrame::toDepthFrame(const RayTable::Ptr &rays, DepthFrame &res) const
+{
+    if(!rays) return false;
+    // Same as RayTable::update, a new layout starts a new table
+    if(!rays->matches(_width, _height)) rays->reset(_width, _height);
+    res.reset(_width, _height, rays);
+    res.header = header;
+    const float maxAmplitude = std::numeric_limits<std::uint16_t>::max();
+    valid.forEach([&](std::size_t i){
+        rays->learn(i, x[i], y[i], z[i]);
+        if(!rays->known(i)) return;
+        const float a = intensity[i];
+        res.setRaw(i, res.quantize(z[i]), (a > 0) ? static_cast<std::uint16_t>(std::min(a + 0.5f, maxAmplitude)) : 0);
+    });
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void 
+nimbus::SoAFrame::crop(float perW, float perH, SoAFrame &res, const RowBands &config) const
+{
+    const int hLower = static_cast<int>((_height * perH) / 2);
+    const int hUpper = _height - hLower;
+    const int wLower = static_cast<int>((_width * perW) / 2);
+    const int wUpper = _width - wLower;
+    const int rows = std::max(hUpper - hLower - 1, 0);
+    const int cols = std::max(wUpper - wLower - 1, 0);
+    res.reset(cols, rows);
+    res.header = header;
+    parallelRows(rows, cols, config, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t r = begin; r < end; ++r)
+        {
+            const std::size_t src = (r + hLower + 1) * _width + wLower + 1;
+            const std::size_t dst = r * cols;
+            std::copy(x.begin() + src, x.begin() + src + cols, res.x.begin() + dst);
+            std::copy(y.begin() + src, y.begin() + src + cols, res.y.begin() + dst);
+            std::copy(z.begin() + src, z.begin() + src + cols, res.z.begin() + dst);
+            std::copy(intensity.begin() + src, intensity.begin() + src + cols, res.intensity.begin() + dst);
+        }
+    });
+    // Bits of neighbouring rows share words, the mask is packed in one pass
+    for(int r = 0; r < rows; ++r)
+    {
+        const std::size_t src = static_cast<std::size_t>(r + hLower + 1) * _width + wLower + 1;
+        const std::size_t dst = static_cast<std::size_t>(r) * cols;
+        for(int c = 0; c < cols; ++c)
+            if(valid.test(src + c)) res.valid.set(dst + c);
+    }
+}
+
+void 
+nimbus::SoAFrame::limitZ(float min, float max, const RowBands &config)
+{
+    parallelRows(valid.words().size(), 64, config, [&](std::size_t begin, std::size_t end, unsigned int){
+        valid.forEach(begin, end, [&](std::size_t i){
+            if(!(z[i] >= min && z[i] <= max)) valid.clear(i);
+        });
+    });
+}
+
+bool 
+nimbus::SoAFrame::subtractBackground(const SoAFrame &ground, float tolerance, const RowBands &config)
+{
+    if(ground.width() != _width || ground.size() != size()) return false;
+    valid &= ground.valid;
+    parallelRows(valid.words().size(), 64, config, [&](std::size_t begin, std::size_t end, unsigned int){
+        valid.forEach(begin, end, [&](std::size_t i){
+            if(!(std::abs(z[i] - ground.z[i]) > tolerance)) valid.clear(i);
+        });
+    });
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int 
+nimbus::SoAFrame::meanAndCovariance(const Bitmask &mask, Eigen::Vector4f &centroid, Eigen::Matrix3f &covariance,
+                                    const RowBands &config) const
+{
+    Bitmask selection = valid;
+    selection &= mask;
+    const std::size_t origin = selection.first();
+    if(origin >= size())
+    {
+        PointMoments().get(centroid, covariance);
+        return 0;
+    }
+    // All bands share the first point as shift
+    const PointMoments m = parallelReduceRows(selection.words().size(), 64, config,
+        PointMoments(x[origin], y[origin], z[origin]),
+        [&](std::size_t begin, std::size_t end, PointMoments &band){
+            selection.forEach(begin, end, [&](std::size_t i){ band.add(x[i], y[i], z[i]); });
+        },
+        [](PointMoments &total, const PointMoments &band){ total += band; });
+    m.get(centroid, covariance);
+    return static_cast<unsigned int>(m.n);
+}
@@ -0,0 +1,248 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file table_plane.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <box_detector/table_plane.hpp>
+
+namespace
+{
+    /** Plane through the centroid along the smallest eigenvector, normal towards the camera, returns the smallest eigenvalue */
+    float solvePlane(const Eigen::Vector4f &centroid, const Eigen::Matrix3f &covariance, Eigen::Vector4f &plane)
+    {
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(covariance);
+        Eigen::Vector3f normal = solver.eigenvectors().col(0);
+        // The camera is at the origin
+        if(normal.dot(centroid.head<3>()) > 0) normal = -normal;
+        plane << normal, -normal.dot(centroid.head<3>());
+        return std::max(solver.eigenvalues()[0], 0.0f);
+    }
+}
+
+nimbus::TablePlane::TablePlane(float margin, float inlierDistance, int cellSize,
+                               float maxCellRms, float maxAngle, float minSupport):
+    _plane(Eigen::Vector4f::Zero()), _valid(false), _warm(false), _inliers(0)
+{
+    setParameter(margin, inlierDistance, cellSize, maxCellRms, maxAngle, minSupport);
+}
+nimbus::TablePlane::~TablePlane(){}
+
+void 
+nimbus::TablePlane::setParameter(float margin, float inlierDistance, int cellSize,
+                                 float maxCellRms, float maxAngle, float minSupport)
+{
+    _margin = margin;
+    _inlierDistance = inlierDistance;
+    _cellSize = std::max(cellSize, 2);
+    _maxCellRms = maxCellRms;
+    _maxAngle = maxAngle;
+    _minSupport = minSupport;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool 
+nimbus::TablePlane::refit(const SoAFrame &frame, const Eigen::Vector4f &plane, const RowBands &config,
+                          Eigen::Vector4f &res, unsigned int &inliers) const
+{
+    inliers = 0;
+    const std::size_t origin = frame.valid.first();
+    if(origin >= frame.size()) return false;
+    const PointMoments m = parallelReduceRows(frame.valid.words().size(), 64, config,
+        PointMoments(frame.x[origin], frame.y[origin], frame.z[origin]),
+        [&](std::size_t begin, std::size_t end, PointMoments &band){
+            frame.valid.forEach(begin, end, [&](std::size_t i){
+                const float distance = plane[0] * frame.x[i] + plane[1] * frame.y[i] + plane[2] * frame.z[i] + plane[3];
+                if(std::abs(distance) <= _inlierDistance) band.add(frame.x[i], frame.y[i], frame.z[i]);
+            });
+        },
+        [](PointMoments &total, const PointMoments &band){ total += band; });
+    if(m.n < 3) return false;
+    Eigen::Vector4f centroid;
+    Eigen::Matrix3f covariance;
+    m.get(centroid, covariance);
+    solvePlane(centroid, covariance, res);
+    inliers = static_cast<unsigned int>(m.n);
+    return true;
+}
+
+int 
+nimbus::TablePlane::find(int i)
+{
+    while(_parent[i] != i)
+    {
+        _parent[i] = _parent[_parent[i]];
+        i = _parent[i];
+    }
+    return i;
+}
+
+bool 
+nimbus::TablePlane::segment(const SoAFrame &frame, const RowBands &config, Eigen::Vector4f &res)
+{
+    const int cellRows = frame.height() / _cellSize, cellCols = frame.width() / _cellSize;
+    const std::size_t cells = static_cast<std::size_t>(cellRows) * cellCols;
+    if(cells == 0) return false;
+    // Plane of every cell, rows of cells in parallel
+    std::vector<PointMoments> moments(cells);
+    std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > planes(cells, Eigen::Vector4f::Zero());
+    std::vector<unsigned char> planar(cells, 0);
+    const float minPoints = 0.5f * _cellSize * _cellSize;
+    parallelRows(cellRows, cellCols * _cellSize * _cellSize, config, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t cr = begin; cr < end; ++cr)
+        {
+            for(int cc = 0; cc < cellCols; ++cc)
+            {
+                const std::size_t cell = cr * cellCols + cc;
+                PointMoments &m = moments[cell];
+                bool first = true;
+                for(int r = 0; r < _cellSize; ++r)
+                {
+                    const std::size_t row = (cr * _cellSize + r) * frame.width() + cc * _cellSize;
+                    for(int c = 0; c < _cellSize; ++c)
+                    {
+                        const std::size_t i = row + c;
+                        if(!frame.valid.test(i)) continue;
+                        if(first)
+                        {
+                            m = PointMoments(frame.x[i], frame.y[i], frame.z[i]);
+                            first = false;
+                        }
+                        m.add(frame.x[i], frame.y[i], frame.z[i]);
+                    }
+                }
+                if(m.n < minPoints) continue;
+                Eigen::Vector4f centroid;
+                Eigen::Matrix3f covariance;
+                m.get(centroid, covariance);
+                planar[cell] = solvePlane(centroid, covariance, planes[cell]) <= _maxCellRms * _maxCellRms;
+            }
+        }
+    });
+
+    // Connected components of planar cells with the same plane
+    const float minCos = std::cos(_maxAngle);
+    _parent.resize(cells);
+    for(std::size_t i = 0; i < cells; ++i) _parent[i] = static_cast<int>(i);
+    auto join = [&](std::size_t a, std::size_t b){
+        if(!planar[a] || !planar[b]) return;
+        const Eigen::Vector4f &pa = planes[a], &pb = planes[b];
+        if(pa.head<3>().dot(pb.head<3>()) < minCos) return;
+        Eigen::Vector4f ca, cb;
+        Eigen::Matrix3f covariance;
+        moments[a].get(ca, covariance);
+        moments[b].get(cb, covariance);
+        if(std::abs(pa.dot(cb)) > _inlierDistance || std::abs(pb.dot(ca)) > _inlierDistance) return;
+        const int ra = find(static_cast<int>(a)), rb = find(static_cast<int>(b));
+        if(ra != rb) _parent[std::max(ra, rb)] = std::min(ra, rb);
+    };
+    for(int cr = 0; cr < cellRows; ++cr)
+    {
+        for(int cc = 0; cc < cellCols; ++cc)
+        {
+            const std::size_t cell = static_cast<std::size_t>(cr) * cellCols + cc;
+            if(cc + 1 < cellCols) join(cell, cell + 1);
+            if(cr + 1 < cellRows) join(cell, cell + cellCols);
+        }
+    }
+    // Largest component by point count
+    std::vector<double> support(cells, 0);
+    for(std::size_t i = 0; i < cells; ++i)
+        if(planar[i]) support[find(static_cast<int>(i))] += moments[i].n;
+    const std::size_t best = std::max_element(support.begin(), support.end()) - support.begin();
+    if(support[best] == 0) return false;
+
+    // Merge the moments of the component around a common origin
+    Eigen::Vector4f centroid;
+    Eigen::Matrix3f covariance;
+    Eigen::Matrix3d scatter = Eigen::Matrix3d::Zero();
+    Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+    double n = 0;
+    for(std::size_t i = 0; i < cells; ++i)
+    {
+        if(!planar[i] || find(static_cast<int>(i)) != static_cast<int>(best)) continue;
+        moments[i].get(centroid, covariance);
+        const Eigen::Vector3d c = centroid.head<3>().cast<double>();
+        const double w = moments[i].n;
+        sum += w * c;
+        scatter += w * (covariance.cast<double>() + c * c.transpose());
+        n += w;
+    }
+    const Eigen::Vector3d mean = sum / n;
+    centroid << mean.cast<float>(), 1.0f;
+    covariance = (scatter / n - mean * mean.transpose()).cast<float>();
+    solvePlane(centroid, covariance, res);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool 
+nimbus::TablePlane::fit(const SoAFrame &frame, const RowBands &config)
+{
+    const std::size_t points = frame.valid.count();
+    const float minCos = std::cos(_maxAngle);
+    Eigen::Vector4f plane;
+    unsigned int inliers = 0;
+    // Warm start, refit the inliers of the last plane
+    if(_valid && refit(frame, _plane, config, plane, inliers) &&
+       inliers >= _minSupport * points && plane.head<3>().dot(_plane.head<3>()) >= minCos)
+    {
+        _plane = plane;
+        _inliers = inliers;
+        _warm = true;
+        return true;
+    }
+    _warm = false;
+    _valid = false;
+    Eigen::Vector4f seed;
+    if(!segment(frame, config, seed)) return false;
+    // Two refits pull in the table pixels of the non planar cells
+    if(!refit(frame, seed, config, plane, inliers) || !refit(frame, plane, config, plane, inliers)) return false;
+    if(inliers < _minSupport * points) return false;
+    _plane = plane;
+    _inliers = inliers;
+    _valid = true;
+    return true;
+}
+
+bool 
+nimbus::TablePlane::foreground(const SoAFrame &frame, Bitmask &mask, const RowBands &config)
+{
+    if(!fit(frame, config))
+    {
+        mask.reset(frame.width(), frame.height());
+        return false;
+    }
+    mask = frame.valid;
+    const Eigen::Vector4f plane = _plane;
+    parallelRows(mask.words().size(), 64, config, [&](std::size_t begin, std::size_t end, unsigned int){
+        mask.forEach(begin, end, [&](std::size_t i){
+            const float height = plane[0] * frame.x[i] + plane[1] * frame.y[i] + plane[2] * frame.z[i] + plane[3];
+            if(!(height > _margin)) mask.clear(i);
+        });
+    });
+    return true;
+}
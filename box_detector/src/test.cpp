@@ -32,6 +32,8 @@
 #include <sensor_msgs/PointCloud2.h>
 
 #include <pcl/io/pcd_io.h>
+#include <pcl_ros/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.h>
 
 #include <box_detector/box_detector.hpp>
 
@@ -49,7 +51,7 @@ int main(int argc, char** argv){
     ros::NodeHandle nh("~");
 
     ros::Publisher pub = nh.advertise<sensor_msgs::PointCloud2>("model_point", 5);
-    nimbus::BoxDetector<pcl::PointXYZ> bDetector(nh);
+    nimbus::BoxDetector<pcl::PointXYZ> bDetector;
 
     pcl::PointCloud<pcl::PointXYZ>::Ptr blob (new pcl::PointCloud<pcl::PointXYZ>());
     pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>());
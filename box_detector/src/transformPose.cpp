@@ -12,12 +12,13 @@ int main(int argc, char** argv){
     tf2_ros::TransformListener tfListener(tfBuffer);
 
     ros::Rate rate(10.0);
+    ros::Time last;
     while (node.ok()){
         geometry_msgs::TransformStamped transformStamped;
-        ros::Time past = ros::Time::now() - ros::Duration(5.0);
         try{
+            // Latest detection, it keeps the sensor time stamp of its frame
             transformStamped = tfBuffer.lookupTransform("iiwa_link_0", "box",
-                                        past, ros::Duration(3.0));
+                                        ros::Time(0), ros::Duration(3.0));
         }
         catch (tf2::TransformException &ex) {
             ROS_WARN("%s",ex.what());
@@ -25,10 +26,17 @@ int main(int argc, char** argv){
             continue;
         }
 
+        // Each detection once, successive stamps give the conveyor velocity
+        if(transformStamped.header.stamp == last){
+            rate.sleep();
+            continue;
+        }
+        last = transformStamped.header.stamp;
+
         geometry_msgs::TransformStamped pose;
         pose.child_frame_id = "iiwa_link_0";
         pose.header.frame_id = "box";
-        pose.header.stamp = ros::Time::now();
+        pose.header.stamp = transformStamped.header.stamp;
         pose.transform.translation.x = transformStamped.transform.translation.x;
         pose.transform.translation.y = transformStamped.transform.translation.y;
         pose.transform.translation.z = transformStamped.transform.translation.z;
@@ -0,0 +1,127 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file workspace_roi.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <box_detector/workspace_roi.hpp>
+
+nimbus::WorkspaceROI::WorkspaceROI(): 
+    _pose(Eigen::Isometry3f::Identity()), _halfSize(Eigen::Vector3f::Zero()),
+    _sensorWidth(0), _sensorHeight(0), _rowBegin(0), _rowEnd(0), _colBegin(0), _colEnd(0){}
+nimbus::WorkspaceROI::~WorkspaceROI(){}
+
+void 
+nimbus::WorkspaceROI::setBox(const Eigen::Isometry3f &pose, const Eigen::Vector3f &size)
+{
+    _pose = pose;
+    _halfSize = size.cwiseAbs() / 2;
+    _near.clear();
+    _far.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool 
+nimbus::WorkspaceROI::update(const Eigen::Isometry3f &baseToCamera, const RayTable &rays)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    _near.clear();
+    _far.clear();
+    _sensorWidth = rays.width();
+    _sensorHeight = rays.height();
+    if(_halfSize.minCoeff() <= 0) return false;
+
+    // Camera rays in box coordinates: origin o and direction d = (rx, ry, 1), the ray parameter is the depth
+    const Eigen::Isometry3f cameraToBox = (baseToCamera * _pose).inverse();
+    const Eigen::Vector3f o = cameraToBox.translation();
+    const Eigen::Matrix3f R = cameraToBox.linear();
+    std::vector<float> nearFull(rays.width() * static_cast<std::size_t>(rays.height()), nan);
+    std::vector<float> farFull(nearFull.size(), nan);
+    int rowBegin = rays.height(), rowEnd = 0, colBegin = rays.width(), colEnd = 0;
+    float minDepth = std::numeric_limits<float>::max(), maxDepth = 0;
+    for(int r = 0; r < rays.height(); ++r)
+    {
+        for(int c = 0; c < rays.width(); ++c)
+        {
+            const std::size_t i = static_cast<std::size_t>(r) * rays.width() + c;
+            if(!rays.known(i)) continue;
+            const Eigen::Vector3f d = R * Eigen::Vector3f(rays.rayX(i), rays.rayY(i), 1.0f);
+            // Slab test
+            float tNear = 0, tFar = std::numeric_limits<float>::max();
+            bool hit = true;
+            for(int k = 0; k < 3 && hit; ++k)
+            {
+                if(std::abs(d[k]) < 1e-9f)
+                {
+                    hit = std::abs(o[k]) <= _halfSize[k];
+                    continue;
+                }
+                float t0 = (-_halfSize[k] - o[k]) / d[k];
+                float t1 = (_halfSize[k] - o[k]) / d[k];
+                if(t0 > t1) std::swap(t0, t1);
+                tNear = std::max(tNear, t0);
+                tFar = std::min(tFar, t1);
+                hit = tNear <= tFar;
+            }
+            if(!hit) continue;
+            nearFull[i] = tNear;
+            farFull[i] = tFar;
+            rowBegin = std::min(rowBegin, r);
+            rowEnd = std::max(rowEnd, r + 1);
+            colBegin = std::min(colBegin, c);
+            colEnd = std::max(colEnd, c + 1);
+            minDepth = std::min(minDepth, tNear);
+            maxDepth = std::max(maxDepth, tFar);
+        }
+    }
+    if(rowEnd <= rowBegin || colEnd <= colBegin) return false;
+
+    _rowBegin = rowBegin;
+    _rowEnd = rowEnd;
+    _colBegin = colBegin;
+    _colEnd = colEnd;
+    const int cols = windowWidth();
+    _near.assign(static_cast<std::size_t>(cols) * windowHeight(), nan);
+    _far.assign(_near.size(), nan);
+    for(int r = 0; r < windowHeight(); ++r)
+    {
+        for(int c = 0; c < cols; ++c)
+        {
+            const std::size_t src = static_cast<std::size_t>(r + _rowBegin) * rays.width() + c + _colBegin;
+            const std::size_t dst = static_cast<std::size_t>(r) * cols + c;
+            if(rays.known(src))
+            {
+                _near[dst] = nearFull[src];
+                _far[dst] = farFull[src];
+            }else{
+                _near[dst] = minDepth;
+                _far[dst] = maxDepth;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,153 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file synthetic_scene.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <Eigen/Geometry>
+
+#include <box_detector/bitmask.hpp>
+#include <box_detector/soa_frame.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Ground truth box on the table in the camera frame, same axes as Cuboid:
+     * x along the width, y along the length, z into the box (away from the camera)
+     */
+    struct SyntheticBox
+    {
+        Eigen::Vector3f topCenter;
+        float yaw;                      // Angle of the x axis to the camera x axis, like Cuboid::yaw
+        float length, width, height;
+
+        Eigen::Matrix3f rotation() const
+        {
+            return Eigen::AngleAxisf(yaw, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+        }
+        Eigen::Vector3f center() const
+        {
+            return topCenter + rotation().col(2) * (height / 2);
+        }
+    };
+
+    /**
+     * @brief Time of flight frame of a pinhole camera looking down on a table with one box.
+     * Every pixel is ray cast against the box (slab test) and the table plane z = tableDepth.
+     * @param box Ground truth box standing on the table
+     * @param tableDepth Distance of the table from the camera in meter
+     * @param width, height Frame layout in pixel
+     * @param focal Focal length in pixel, the principal point is the frame center
+     * @param noise Standard deviation of the range noise in meter, 0 for an exact frame
+     * @param frame Rendered frame, all pixels valid, amplitude 1000
+     * @param boxMask Pixels that hit the box
+     */
+    inline void renderScene(const SyntheticBox &box, float tableDepth, int width, int height, float focal,
+                            float noise, SoAFrame &frame, Bitmask &boxMask)
+    {
+        const Eigen::Matrix3f R = box.rotation();
+        const Eigen::Vector3f half(box.width / 2, box.length / 2, box.height / 2);
+        const Eigen::Vector3f origin = -(R.transpose() * box.center());
+        // Fixed seed, every run renders the same frame
+        std::mt19937 random(7);
+        std::normal_distribution<float> gauss(0.0f, noise > 0 ? noise : 1.0f);
+        frame.reset(width, height);
+        boxMask.reset(width, height);
+        for(int r = 0; r < height; ++r)
+        {
+            for(int c = 0; c < width; ++c)
+            {
+                const std::size_t i = static_cast<std::size_t>(r) * width + c;
+                const Eigen::Vector3f ray((c - (width - 1) / 2.0f) / focal, (r - (height - 1) / 2.0f) / focal, 1.0f);
+                float t = tableDepth;
+                // Slab test in the box frame
+                const Eigen::Vector3f d = R.transpose() * ray;
+                float tNear = -std::numeric_limits<float>::infinity(), tFar = std::numeric_limits<float>::infinity();
+                for(int k = 0; k < 3; ++k)
+                {
+                    if(std::abs(d[k]) < 1e-9f)
+                    {
+                        if(std::abs(origin[k]) > half[k]) tNear = std::numeric_limits<float>::infinity();
+                        continue;
+                    }
+                    const float t0 = (-half[k] - origin[k]) / d[k], t1 = (half[k] - origin[k]) / d[k];
+                    tNear = std::max(tNear, std::min(t0, t1));
+                    tFar = std::min(tFar, std::max(t0, t1));
+                }
+                if(tNear <= tFar && tNear > 0 && tNear < t)
+                {
+                    t = tNear;
+                    boxMask.set(i);
+                }
+                if(noise > 0) t += gauss(random) / ray.norm();
+                frame.x[i] = t * ray.x();
+                frame.y[i] = t * ray.y();
+                frame.z[i] = t;
+                frame.intensity[i] = 1000.0f;
+                frame.valid.set(i);
+            }
+        }
+    }
+
+    /** Scene of the tests: 160 x 120 pixel camera with 120 pixel focal length, 0.9 m above the table */
+    const float DEG = static_cast<float>(M_PI) / 180.0f;
+    const float TABLE_DEPTH = 0.9f;
+    const int FRAME_WIDTH = 160;
+    const int FRAME_HEIGHT = 120;
+    const float FOCAL = 120.0f;
+    const float NOISE = 0.001f;
+
+    /**
+     * @brief Box well off the optical axis and turned by 45 degree against it, a side face and an
+     * end face are visible. Without them the lateral position is not observable from the top face alone.
+     */
+    inline SyntheticBox offAxisBox()
+    {
+        SyntheticBox box;
+        box.length = 0.20f;
+        box.width = 0.12f;
+        box.height = 0.12f;
+        box.yaw = -15 * DEG;
+        box.topCenter = Eigen::Vector3f(0.24f, 0.15f, TABLE_DEPTH - box.height);
+        return box;
+    }
+
+    /** @brief renderScene with the test camera and table */
+    inline void renderScene(const SyntheticBox &box, float noise, SoAFrame &frame, Bitmask &boxMask)
+    {
+        renderScene(box, TABLE_DEPTH, FRAME_WIDTH, FRAME_HEIGHT, FOCAL, noise, frame, boxMask);
+    }
+
+    /** Difference of two yaw angles of a symmetric box, in [0, pi/2] */
+    inline float yawError(float a, float b)
+    {
+        float d = std::fmod(std::abs(a - b), static_cast<float>(M_PI));
+        return std::min(d, static_cast<float>(M_PI) - d);
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file test_box_tracker.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Constant velocity Kalman tracker of the box pose
+ */
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+#include <box_detector/box_tracker.hpp>
+
+using namespace nimbus;
+
+TEST(BoxTracker, PredictTimeout)
+{
+    BoxTracker tracker(0.01, 0.05, 0.005, 0.05, 2.0);
+    BoxTracker::State state;
+    BoxTracker::Covariance covariance;
+    EXPECT_FALSE(tracker.predict(0.0, state, covariance));
+
+    tracker.update(10.0, Eigen::Vector3d(0.5, 0.0, 1.2), 0.1);
+    EXPECT_TRUE(tracker.predict(11.5, state, covariance));
+    EXPECT_NEAR(state[0], 0.5, 1e-9);
+    EXPECT_FALSE(tracker.predict(12.5, state, covariance));
+    EXPECT_TRUE(std::isinf(tracker.distance(12.5, Eigen::Vector3d(0.5, 0.0, 1.2))));
+}
+
+TEST(BoxTracker, GateRestartsTrack)
+{
+    BoxTracker tracker;
+    for(int i = 0; i < 10; ++i) tracker.update(0.1 * i, Eigen::Vector3d(0.5, 0.0, 1.2), 0.1);
+    EXPECT_LT(tracker.distance(1.0, Eigen::Vector3d(0.5, 0.0, 1.2)), 1.0);
+
+    // Another box 40 cm away, far outside the gate
+    const Eigen::Vector3d other(0.9, 0.0, 1.2);
+    EXPECT_GT(tracker.distance(1.0, other), 20.0);
+    tracker.update(1.0, other, -0.4);
+    EXPECT_NEAR(tracker.state()[0], 0.9, 1e-9);
+    EXPECT_NEAR(tracker.state()[3], -0.4, 1e-9);
+    // The jump must not show up as velocity
+    EXPECT_NEAR(tracker.state()[4], 0.0, 1e-9);
+    EXPECT_DOUBLE_EQ(tracker.stamp(), 1.0);
+}
+
+TEST(BoxTracker, YawWrap)
+{
+    EXPECT_NEAR(BoxTracker::wrapYaw(M_PI / 2 + 0.1), -M_PI / 2 + 0.1, 1e-12);
+    EXPECT_NEAR(BoxTracker::wrapYaw(-M_PI / 2 - 0.1), M_PI / 2 - 0.1, 1e-12);
+    EXPECT_NEAR(BoxTracker::wrapYaw(M_PI + 0.2), 0.2, 1e-12);
+
+    // A box at 89 degree is measured alternately at +89 and -89 degree, the same box orientation
+    BoxTracker tracker;
+    const double yaw = 89.0 * M_PI / 180.0;
+    for(int i = 0; i < 20; ++i)
+        tracker.update(0.1 * i, Eigen::Vector3d(0.5, 0.0, 1.2), i % 2 ? yaw : yaw - M_PI);
+    const double error = BoxTracker::wrapYaw(tracker.state()[3] - yaw);
+    EXPECT_LT(std::abs(error), 1.0 * M_PI / 180.0);
+    EXPECT_LT(std::abs(tracker.state()[7]), 0.05);
+}
+
+TEST(BoxTracker, ConstantVelocity)
+{
+    BoxTracker tracker;
+    const Eigen::Vector3d start(0.2, -0.1, 1.2), velocity(0.3, 0.05, 0.0);
+    const double yawRate = 0.2;
+    for(int i = 0; i < 50; ++i)
+    {
+        const double t = 0.05 * i;
+        tracker.update(t, start + velocity * t, 0.1 + yawRate * t);
+    }
+    const BoxTracker::State &x = tracker.state();
+    EXPECT_NEAR(x[4], velocity.x(), 0.01);
+    EXPECT_NEAR(x[5], velocity.y(), 0.01);
+    EXPECT_NEAR(x[6], velocity.z(), 0.01);
+    EXPECT_NEAR(x[7], yawRate, 0.02);
+
+    // Half a second ahead along the track
+    BoxTracker::State state;
+    BoxTracker::Covariance covariance;
+    ASSERT_TRUE(tracker.predict(2.95, state, covariance));
+    EXPECT_LT((state.head<3>() - (start + velocity * 2.95)).norm(), 0.005);
+}
@@ -0,0 +1,69 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file test_contour.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Single frame yaw from the top face contour of a rendered box
+ */
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+#include <box_detector/contour.hpp>
+#include "synthetic_scene.hpp"
+
+using namespace nimbus;
+
+TEST(ContourYaw, TopFace)
+{
+    const SyntheticBox box = offAxisBox();
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(box, NOISE, frame, boxMask);
+
+    // Top face only, the side faces are not part of the outline
+    Bitmask top;
+    top.reset(FRAME_WIDTH, FRAME_HEIGHT);
+    boxMask.forEach([&](std::size_t i){
+        if(std::abs(frame.z[i] - box.topCenter.z()) < 0.005f) top.set(i);
+    });
+
+    float yaw, length, width, support;
+    ASSERT_TRUE(contourYaw(frame, top, Eigen::Vector3f::UnitZ(), yaw, length, width, support));
+    EXPECT_LT(yawError(yaw, box.yaw), 1 * DEG);
+    EXPECT_NEAR(length, box.length, 0.01f);
+    EXPECT_NEAR(width, box.width, 0.01f);
+    EXPECT_GT(support, 0.5f);
+}
+
+TEST(ContourYaw, TooSmall)
+{
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(offAxisBox(), 0.0f, frame, boxMask);
+    Bitmask pixel;
+    pixel.reset(FRAME_WIDTH, FRAME_HEIGHT);
+    pixel.set(FRAME_WIDTH * FRAME_HEIGHT / 2);
+    float yaw, length, width, support;
+    EXPECT_FALSE(contourYaw(frame, pixel, Eigen::Vector3f::UnitZ(), yaw, length, width, support));
+}
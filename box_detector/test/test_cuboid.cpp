@@ -0,0 +1,81 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file test_cuboid.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Cuboid pose and dimensions of a rendered box
+ */
+
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <box_detector/cuboid.hpp>
+#include <box_detector/robust_plane.hpp>
+#include <box_detector/table_plane.hpp>
+#include "synthetic_scene.hpp"
+
+using namespace nimbus;
+
+TEST(Cuboid, Estimate)
+{
+    const SyntheticBox box = offAxisBox();
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(box, NOISE, frame, boxMask);
+
+    TablePlane table;
+    ASSERT_TRUE(table.fit(frame));
+    RobustPlane robust;
+    Eigen::Vector4f topPlane;
+    float curvature;
+    ASSERT_TRUE(robust.fit(frame, boxMask, topPlane, curvature));
+
+    Cuboid cuboid;
+    ASSERT_TRUE(estimateCuboid(frame, boxMask, topPlane, table.plane(), 2 * robust.threshold(), cuboid));
+    EXPECT_LT((cuboid.topCenter - box.topCenter).norm(), 0.003f);
+    EXPECT_LT(yawError(cuboid.yaw, box.yaw), 1 * DEG);
+    EXPECT_NEAR(cuboid.length, box.length, 0.005f);
+    EXPECT_NEAR(cuboid.width, box.width, 0.005f);
+    EXPECT_NEAR(cuboid.height, box.height, 0.002f);
+    EXPECT_LT(cuboid.tilt, 0.5f * DEG);
+}
+
+TEST(Cuboid, WithoutTable)
+{
+    const SyntheticBox box = offAxisBox();
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(box, NOISE, frame, boxMask);
+
+    RobustPlane robust;
+    Eigen::Vector4f topPlane;
+    float curvature;
+    ASSERT_TRUE(robust.fit(frame, boxMask, topPlane, curvature));
+    Cuboid cuboid;
+    ASSERT_TRUE(estimateCuboid(frame, boxMask, topPlane, Eigen::Vector4f::Constant(std::numeric_limits<float>::quiet_NaN()),
+                               2 * robust.threshold(), cuboid));
+    EXPECT_TRUE(std::isnan(cuboid.height));
+    EXPECT_LT((cuboid.topCenter - box.topCenter).norm(), 0.003f);
+    EXPECT_LT((cuboid.center - cuboid.topCenter).norm(), 1e-6f);
+}
@@ -0,0 +1,114 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file test_cuboid_refiner.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Gauss-Newton cuboid refinement from a perturbed pose of a rendered box
+ */
+
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <box_detector/cuboid_refiner.hpp>
+#include "synthetic_scene.hpp"
+
+using namespace nimbus;
+
+namespace
+{
+    /** Yaw of the width axis in the camera x-y plane, the plane basis of a camera looking down */
+    float cuboidYaw(const Cuboid &cuboid)
+    {
+        const Eigen::Vector3f xAxis = cuboid.orientation.toRotationMatrix().col(0);
+        return std::atan2(xAxis.y(), xAxis.x());
+    }
+}
+
+TEST(CuboidRefiner, Perturbed)
+{
+    const SyntheticBox box = offAxisBox();
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(box, NOISE, frame, boxMask);
+
+    // Ground truth dimensions, pose off by 3 degree and 1 cm
+    Cuboid cuboid;
+    const Eigen::Matrix3f R = Eigen::AngleAxisf(box.yaw + 3 * DEG, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+    cuboid.length = box.length;
+    cuboid.width = box.width;
+    cuboid.height = box.height;
+    cuboid.orientation = Eigen::Quaternionf(R);
+    cuboid.center = box.center() + Eigen::Vector3f(0.008f, -0.006f, 0.0f);
+    cuboid.topCenter = cuboid.center - R.col(2) * (box.height / 2);
+
+    Bitmask roi = boxMask;
+    roi.dilate(3);
+    CuboidRefiner refiner;
+    ASSERT_TRUE(refiner.refine(frame, roi, cuboid));
+    EXPECT_GT(refiner.iterations(), 0);
+    EXPECT_GT(refiner.inliers(), boxMask.count() * 9 / 10);
+    EXPECT_LT((cuboid.topCenter - box.topCenter).norm(), 0.001f);
+    EXPECT_LT((cuboid.center - box.center()).norm(), 0.001f);
+    EXPECT_LT(yawError(cuboidYaw(cuboid), box.yaw), 0.5f * DEG);
+}
+
+TEST(CuboidRefiner, NeedsHeight)
+{
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(offAxisBox(), 0.0f, frame, boxMask);
+    Cuboid cuboid;
+    cuboid.height = std::numeric_limits<float>::quiet_NaN();
+    CuboidRefiner refiner;
+    EXPECT_FALSE(refiner.refine(frame, boxMask, cuboid));
+}
+
+TEST(CuboidRefiner, Convergence)
+{
+    const SyntheticBox box = offAxisBox();
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(box, 0.0f, frame, boxMask);
+    Cuboid cuboid;
+    cuboid.length = box.length;
+    cuboid.width = box.width;
+    cuboid.height = box.height;
+    cuboid.orientation = Eigen::Quaternionf(box.rotation());
+    cuboid.center = box.center() + Eigen::Vector3f(0.003f, 0.0f, 0.0f);
+    cuboid.topCenter = cuboid.center - box.rotation().col(2) * (box.height / 2);
+
+    // One step is not enough, the moved pose is still returned
+    Cuboid single = cuboid;
+    CuboidRefiner refiner(1);
+    ASSERT_TRUE(refiner.refine(frame, boxMask, single));
+    EXPECT_FALSE(refiner.converged());
+    EXPECT_EQ(refiner.iterations(), 1);
+    EXPECT_LT((single.center - box.center()).norm(), (cuboid.center - box.center()).norm());
+
+    refiner.setParameter(20, 0.02f, 0.002f, 1e-3f);
+    ASSERT_TRUE(refiner.refine(frame, boxMask, cuboid));
+    EXPECT_TRUE(refiner.converged());
+    EXPECT_LT(refiner.iterations(), 20);
+    EXPECT_LT((cuboid.center - box.center()).norm(), 1e-4f);
+}
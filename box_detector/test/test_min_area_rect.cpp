@@ -0,0 +1,63 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file test_min_area_rect.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Minimum area rectangle of a rotated point grid
+ */
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <box_detector/min_area_rect.hpp>
+#include "synthetic_scene.hpp"
+
+using namespace nimbus;
+
+TEST(MinAreaRect, RotatedGrid)
+{
+    const float yaw = 30 * DEG, length = 0.4f, width = 0.1f;
+    const Eigen::Vector2f center(0.5f, -0.2f);
+    const Eigen::Vector2f l(std::cos(yaw), std::sin(yaw)), w(-std::sin(yaw), std::cos(yaw));
+    std::vector<Eigen::Vector2f> points, hull;
+    for(int i = 0; i <= 40; ++i)
+        for(int j = 0; j <= 10; ++j)
+            points.push_back(center + l * (length * (i / 40.0f - 0.5f)) + w * (width * (j / 10.0f - 0.5f)));
+    convexHull(points, hull);
+
+    RotatedRect rect;
+    ASSERT_TRUE(minAreaRect(hull, rect));
+    EXPECT_NEAR(rect.length, length, 1e-4f);
+    EXPECT_NEAR(rect.width, width, 1e-4f);
+    EXPECT_NEAR(rect.area, length * width, 1e-4f);
+    EXPECT_LT(yawError(rect.yaw, yaw), 1e-3f);
+    EXPECT_LT((rect.center - center).norm(), 1e-4f);
+}
+
+TEST(MinAreaRect, TooFewPoints)
+{
+    std::vector<Eigen::Vector2f> hull(2, Eigen::Vector2f::Zero());
+    RotatedRect rect;
+    EXPECT_FALSE(minAreaRect(hull, rect));
+}
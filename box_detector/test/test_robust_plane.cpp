@@ -0,0 +1,91 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file test_robust_plane.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Robust top face plane of a rendered box, the side faces are the outliers
+ */
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+#include <box_detector/robust_plane.hpp>
+#include "synthetic_scene.hpp"
+
+using namespace nimbus;
+
+namespace
+{
+    void expectTopFace(const SyntheticBox &box, const Eigen::Vector4f &plane)
+    {
+        EXPECT_GT(plane.head<3>().dot(-Eigen::Vector3f::UnitZ()), std::cos(0.5f * DEG));
+        EXPECT_NEAR(plane[3] / -plane[2], box.topCenter.z(), 0.002f);
+    }
+}
+
+TEST(RobustPlane, Ransac)
+{
+    const SyntheticBox box = offAxisBox();
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(box, NOISE, frame, boxMask);
+
+    RobustPlane robust;
+    Eigen::Vector4f plane, again;
+    float curvature;
+    ASSERT_TRUE(robust.fit(frame, boxMask, plane, curvature));
+    expectTopFace(box, plane);
+    EXPECT_LT(curvature, 0.01f);
+    // Seeded sampler, every fit gives the same plane
+    ASSERT_TRUE(robust.fit(frame, boxMask, again, curvature));
+    EXPECT_EQ(plane, again);
+}
+
+TEST(RobustPlane, LMedS)
+{
+    const SyntheticBox box = offAxisBox();
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(box, NOISE, frame, boxMask);
+
+    RobustPlane robust(0.005f, 0.99f, 200, 4096, 42, PlaneEstimator::LMEDS);
+    Eigen::Vector4f plane;
+    float curvature;
+    ASSERT_TRUE(robust.fit(frame, boxMask, plane, curvature));
+    expectTopFace(box, plane);
+}
+
+TEST(RobustPlane, TooFewPoints)
+{
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(offAxisBox(), 0.0f, frame, boxMask);
+    Bitmask two;
+    two.reset(FRAME_WIDTH, FRAME_HEIGHT);
+    two.set(0);
+    two.set(1);
+    RobustPlane robust;
+    Eigen::Vector4f plane;
+    float curvature;
+    EXPECT_FALSE(robust.fit(frame, two, plane, curvature));
+}
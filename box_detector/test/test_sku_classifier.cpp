@@ -0,0 +1,128 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file test_sku_classifier.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Dimension based SKU classification
+ */
+
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+
+#include <box_detector/sku_classifier.hpp>
+
+using namespace nimbus;
+
+namespace
+{
+    Sku sku(const char *name, float length, float width, float height, float tolerance)
+    {
+        Sku s;
+        s.name = name;
+        s.length = length;
+        s.width = width;
+        s.height = height;
+        s.tolerance = tolerance;
+        return s;
+    }
+    const float NO_HEIGHT = std::numeric_limits<float>::quiet_NaN();
+}
+
+TEST(SkuClassifier, Match)
+{
+    SkuClassifier skus;
+    ASSERT_TRUE(skus.add(sku("small", 0.20f, 0.075f, 0.15f, 0.01f)));
+    ASSERT_TRUE(skus.add(sku("large", 0.40f, 0.30f, 0.20f, 0.01f)));
+
+    SkuMatch match = skus.classify(0.202f, 0.074f, 0.151f);
+    EXPECT_EQ(match.index, 0);
+    EXPECT_FALSE(match.ambiguous);
+    EXPECT_NEAR(match.distance, 0.2f, 1e-4f);
+    EXPECT_EQ(skus.name(match), "small");
+    EXPECT_NEAR(skus.score(match), 0.8f, 1e-4f);
+
+    // Nothing within tolerance
+    match = skus.classify(0.30f, 0.20f, 0.15f);
+    EXPECT_EQ(match.index, -1);
+    EXPECT_EQ(skus.name(match), "unknown");
+    EXPECT_EQ(skus.score(match), 0.0f);
+}
+
+TEST(SkuClassifier, SwappedSides)
+{
+    SkuClassifier skus;
+    // Width and length given the wrong way round in the table and in the measurement
+    ASSERT_TRUE(skus.add(sku("small", 0.075f, 0.20f, 0.15f, 0.01f)));
+    EXPECT_EQ(skus[0].length, 0.20f);
+    EXPECT_EQ(skus.classify(0.075f, 0.20f, 0.15f).index, 0);
+    EXPECT_EQ(skus.classify(0.20f, 0.075f, 0.15f).index, 0);
+}
+
+TEST(SkuClassifier, Height)
+{
+    SkuClassifier skus;
+    ASSERT_TRUE(skus.add(sku("flat", 0.20f, 0.10f, 0.05f, 0.01f)));
+    ASSERT_TRUE(skus.add(sku("any", 0.30f, 0.10f, 0.0f, 0.01f)));
+    EXPECT_EQ(skus.classify(0.20f, 0.10f, 0.10f).index, -1);
+    // Unknown height is not compared
+    EXPECT_EQ(skus.classify(0.20f, 0.10f, NO_HEIGHT).index, 0);
+    // SKU without height
+    EXPECT_EQ(skus.classify(0.30f, 0.10f, 0.50f).index, 1);
+}
+
+TEST(SkuClassifier, ZeroTolerance)
+{
+    SkuClassifier skus;
+    EXPECT_FALSE(skus.add(sku("exact", 0.20f, 0.10f, 0.05f, 0.0f)));
+    EXPECT_FALSE(skus.add(sku("negative", 0.20f, 0.10f, 0.05f, -0.01f)));
+    EXPECT_TRUE(skus.empty());
+    EXPECT_EQ(skus.classify(0.20f, 0.10f, 0.05f).index, -1);
+}
+
+TEST(SkuClassifier, Ambiguity)
+{
+    SkuClassifier skus(0.5f);
+    ASSERT_TRUE(skus.add(sku("a", 0.200f, 0.10f, 0.0f, 0.01f)));
+    ASSERT_TRUE(skus.add(sku("b", 0.210f, 0.10f, 0.0f, 0.01f)));
+
+    // 0.2 and 0.8 tolerances away, clear enough
+    SkuMatch match = skus.classify(0.202f, 0.10f, NO_HEIGHT);
+    EXPECT_EQ(match.index, 0);
+    EXPECT_FALSE(match.ambiguous);
+    EXPECT_NEAR(match.gap, 0.6f, 1e-4f);
+    EXPECT_EQ(skus.name(match), "a");
+
+    // Between both, 0.4 and 0.6 tolerances away
+    match = skus.classify(0.204f, 0.10f, NO_HEIGHT);
+    EXPECT_GE(match.index, 0);
+    EXPECT_TRUE(match.ambiguous);
+    EXPECT_EQ(skus.name(match), "ambiguous");
+    EXPECT_NEAR(skus.score(match), 0.6f * 0.2f / 0.5f, 1e-3f);
+
+    // Without margin nothing is ambiguous
+    skus.setMargin(0.0f);
+    match = skus.classify(0.204f, 0.10f, NO_HEIGHT);
+    EXPECT_FALSE(match.ambiguous);
+    EXPECT_NEAR(skus.score(match), 0.6f, 1e-3f);
+}
@@ -0,0 +1,56 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @file test_table_plane.cpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ * @brief Table plane fit and foreground of a rendered box scene
+ */
+
+#include <gtest/gtest.h>
+
+#include <box_detector/table_plane.hpp>
+#include "synthetic_scene.hpp"
+
+using namespace nimbus;
+
+TEST(TablePlane, Fit)
+{
+    SoAFrame frame;
+    Bitmask boxMask;
+    renderScene(offAxisBox(), NOISE, frame, boxMask);
+
+    TablePlane table;
+    ASSERT_TRUE(table.fit(frame));
+    const Eigen::Vector4f &plane = table.plane();
+    // Normal towards the camera
+    EXPECT_GT(plane.head<3>().dot(-Eigen::Vector3f::UnitZ()), std::cos(0.5f * DEG));
+    EXPECT_NEAR(plane[3] / -plane[2], TABLE_DEPTH, 0.001f);
+
+    // Everything that is not table is the box
+    Bitmask foreground;
+    ASSERT_TRUE(table.foreground(frame, foreground));
+    Bitmask overlap = foreground;
+    overlap &= boxMask;
+    EXPECT_GT(overlap.count(), boxMask.count() * 9 / 10);
+    EXPECT_LT(foreground.count(), boxMask.count() * 11 / 10);
+}
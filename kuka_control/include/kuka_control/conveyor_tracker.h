@@ -0,0 +1,63 @@
+#ifndef _CONVEYOR_TRACKER_H
+#define _CONVEYOR_TRACKER_H
+
+#include <deque>
+
+#include <ros/time.h>
+#include <tf2/LinearMath/Vector3.h>
+
+namespace iwtros{
+    /** Belt velocity from successive detections of the same box.
+     * The velocity is the least squares slope over the last detections,
+     * each detection is stamped with the time of its sensor frame.
+     */
+    class ConveyorTracker
+    {
+    private:
+        struct Sample
+        {
+            ros::Time stamp;
+            tf2::Vector3 position;
+        };
+        std::deque<Sample> _samples;
+        std::size_t _window;
+        double _timeout;
+        double _maxJump;
+        double _minSpeed;
+        // Least squares line: position = _mean + _velocity * (t - _meanStamp)
+        tf2::Vector3 _mean;
+        tf2::Vector3 _velocity;
+        ros::Time _meanStamp;
+        bool _valid;
+        void fit();
+    public:
+        /** window: detections used for the fit
+         *  timeout: restart if no detection arrived for this long (s)
+         *  maxJump: restart if a detection is further from the prediction, e.g. the next box (m)
+         *  minSpeed: slower boxes are treated as standing still (m/s)
+         */
+        ConveyorTracker(std::size_t window = 10, double timeout = 2.0, double maxJump = 0.1, double minSpeed = 0.005);
+        ~ConveyorTracker();
+        void setParam(std::size_t window, double timeout, double maxJump, double minSpeed);
+        void reset();
+
+        /** Add a detection, returns false for repeated or out of order stamps */
+        bool update(const ros::Time &stamp, const tf2::Vector3 &position);
+
+        /** At least three detections of the same box */
+        bool valid() const { return _valid; }
+        /** The box moves faster than minSpeed */
+        bool moving() const { return _valid && _velocity.length() >= _minSpeed; }
+        const tf2::Vector3 &velocity() const { return _velocity; }
+        ros::Time lastStamp() const { return _samples.empty() ? ros::Time() : _samples.back().stamp; }
+
+        /** Position of the box at stamp, the mean of the detections if it stands still */
+        tf2::Vector3 predict(const ros::Time &stamp) const;
+        /** Distance of a detection from the prediction at stamp,
+         *  infinity without detections or after the timeout (the detection starts a new track)
+         */
+        double distance(const ros::Time &stamp, const tf2::Vector3 &position) const;
+    };
+}
+
+#endif // !_CONVEYOR_TRACKER_H
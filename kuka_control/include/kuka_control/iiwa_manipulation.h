@@ -2,6 +2,7 @@
 #define _IIWA_MANIPULATION_H
 
 #include <queue>
+#include <mutex>
 
 #include <ros/ros.h>
 #include <geometry_msgs/PoseStamped.h>
@@ -13,6 +14,8 @@
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <moveit_msgs/ExecuteTrajectoryAction.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 #include <geometry_msgs/Transform.h>
 #include <tf2_ros/transform_listener.h>
@@ -20,22 +23,47 @@
 #include <std_msgs/Bool.h>
 
 #include <kuka_control/schunk_gripper.h>
+#include <kuka_control/conveyor_tracker.h>
+#include <kuka_control/pick_queue.h>
+#include <kuka_control/trajectory_cache.h>
 
 #include <iwtros_msgs/plcControl.h>
 #include <iwtros_msgs/kukaControl.h>
+#include <iwtros_msgs/objectDetections.h>
 
 namespace iwtros{
+    /** One arm motion of the pick and place pipeline and the gripper command on arrival */
+    struct MotionSegment
+    {
+        enum Gripper { NONE, OPEN, CLOSE };
+        geometry_msgs::PoseStamped pose;
+        Gripper gripper = NONE;
+        // Follow the belt, the goal is predicted for the planned arrival time and planned when the
+        // segment starts, the approach before and the retreat after are shifted by the same correction
+        bool track = false;
+        // Send the gripper command when the segment starts, it only has to be done on arrival
+        bool early = false;
+        // The close has to hold a box, otherwise only the next segment (the retreat) runs
+        bool grasp = false;
+        // Straight line of the tool (approach and retreat) instead of a PTP plan
+        bool linear = false;
+    };
+
     class iiwaMove : public schunkGripper
     {
     private:
         ros::NodeHandle _nh;
         ros::Subscriber _sub;
+        ros::Subscriber _objectsSub;
         ros::Subscriber _accpSub;
         ros::Publisher _plcPub;
         ros::Subscriber _plcSub;
         bool _initialized = false;
         moveit::planning_interface::MoveGroupInterface move_group;
+        // Own execute client, the arm completion is awaited while the next segment is planned
+        actionlib::SimpleActionClient<moveit_msgs::ExecuteTrajectoryAction> _executor;
         tf2_ros::Buffer buffer;
+        tf2_ros::TransformListener _listener;
         // moveit parameters
         /** ToDo:
          * Currently parameters are hard coded.
@@ -47,11 +75,46 @@ namespace iwtros{
         std::string EE_FRAME;
         double velocityScalling;
         double accelerationScalling;
+        // Time a segment may exceed its planned duration before it is cancelled (s)
+        double _executionMargin;
+        // Cartesian interpolation step (m) and joint jump threshold of LIN segments
+        double _linStep;
+        double _linJumpThreshold;
         geometry_msgs::Transform detected_pose;
+        // objectDetections of the one detector that feeds the picks and the belt tracking,
+        // empty for the single box TF chain on /detected_goal
+        std::string _detectionsTopic;
         geometry_msgs::PoseStamped pick_pose;
         bool ready_pick_pose, _accept_pose;
         iwtros_msgs::plcControl _plcSubscriberControl; 
         iwtros_msgs::kukaControl _plcKUKA; 
+        // Detections of a box on the moving belt
+        std::mutex _detectionLock;
+        ConveyorTracker _conveyor;
+        // All boxes of the last detection, several picks per accepted detection
+        PickQueue _picks;
+        // Time to wait for a detection that confirms the queue after a pick (s)
+        double _revalidateTimeout;
+        // Plans of the recurring motions, rechecked against the current scene before reuse
+        bool _useTrajectoryCache;
+        TrajectoryCache _trajectories;
+        planning_scene_monitor::PlanningSceneMonitorPtr _sceneMonitor;
+
+        /** Grasp pose above a detection in the reference frame */
+        geometry_msgs::PoseStamped _graspPose(const geometry_msgs::Transform &detection);
+        /** Pick pose and belt tracking from one detection in the reference frame */
+        void _updatePick(const ros::Time &stamp, const geometry_msgs::Transform &detection);
+        /** Shift the segments up to the tracked grasp (and its retreat) to where the box is when the
+         *  planned motions from start reach the grasp, nothing if segment k or k + 1 is not tracked
+         */
+        void _followBelt(std::vector<MotionSegment> &segments, std::size_t k, const robot_state::RobotState &start);
+        /** Wait for a detection newer than the last pick, false on timeout */
+        bool _revalidatePicks();
+        /** Boxes of the accepted detection are left */
+        bool _queuedPicks();
+        /** (Re)subscribe to the configured detection source */
+        void _subscribeDetections();
+        void _shutdownDetections();
 
     public:
         iiwaMove(ros::NodeHandle nh, const std::string planning_group);
@@ -64,6 +127,8 @@ namespace iwtros{
 
         /** Detected Pose Callback*/ 
         void callback(const geometry_msgs::TransformStamped::ConstPtr& data);
+        /** All verified instances of a frame, the best one is picked*/ 
+        void objectsCallback(const iwtros_msgs::objectDetections::ConstPtr& data);
         void acceptCallback(const std_msgs::Bool::ConstPtr &data);
 
         /** Return geometry pose from given poisition values*/
@@ -75,16 +140,32 @@ namespace iwtros{
                                                 double roll, double pitch, double yaw,
                                                 std::string base_link);
 
+        /** Pick pose with the position the box will have at graspTime on the belt */
+        geometry_msgs::PoseStamped predictPickPose(const ros::Time &graspTime);
+
         /** Genarate Motion contraints for Pilz industrial motion*/
         void motionContraints(const geometry_msgs::PoseStamped pose);
         
         /** Motion execution pipe line */
         void motionExecution(const geometry_msgs::PoseStamped pose);
+
+        /** Plan (or reuse) a motion to pose from an arbitrary start state, linear: straight tool path */
+        bool planSegment(const geometry_msgs::PoseStamped &pose, const robot_state::RobotState &start,
+                         moveit::planning_interface::MoveGroupInterface::Plan &plan, bool linear = false);
+        /** Straight tool path by IK interpolation, time parameterized with the velocity scaling */
+        bool planLinear(const geometry_msgs::PoseStamped &pose, const robot_state::RobotState &start,
+                        moveit::planning_interface::MoveGroupInterface::Plan &plan);
+
+        /** Execute segments in order, segment k+1 is planned from the goal of k while k executes.
+         * A segment that can not be planned, fails or times out aborts the sequence before its gripper command.
+         * Returns false if the sequence was aborted or a grasp found no box */
+        bool executeSegments(std::vector<MotionSegment> segments);
         
-        /** Pick and Place Pipeline */
-        void pnpPipeLine(geometry_msgs::PoseStamped pick,
+        /** Pick and Place Pipeline, conveyor: the descent follows the predicted box position.
+         * Returns false if the box was not grasped and placed */
+        bool pnpPipeLine(geometry_msgs::PoseStamped pick,
                         geometry_msgs::PoseStamped place,
-                        const double offset);
+                        const double offset, bool conveyor = false);
 
         /** Rviz visual marker*/
         void visualMarkers(const geometry_msgs::PoseStamped target_pose,
@@ -0,0 +1,73 @@
+#ifndef _PICK_QUEUE_H
+#define _PICK_QUEUE_H
+
+#include <string>
+#include <vector>
+
+#include <ros/time.h>
+#include <geometry_msgs/Pose.h>
+
+namespace iwtros{
+    /** One box of a detection, pose is the grasp pose in the reference frame */
+    struct PickJob
+    {
+        std::string model_id;
+        geometry_msgs::Pose pose;
+        float score;
+    };
+
+    /** Pick order for all boxes of a detection.
+     * The next job is the one with the shortest estimated travel from the end effector
+     * that has no other box stacked on it. Boxes with a neighbour closer than the gripper
+     * clearance are deferred, their neighbours are picked first.
+     * Detections refresh the queue between picks, detections taken before the last pick
+     * ended are ignored because they still show the picked box.
+     */
+    class PickQueue
+    {
+    private:
+        std::vector<PickJob> _jobs;
+        ros::Time _stamp;
+        ros::Time _pickedAt;
+        double _linearSpeed;
+        double _angularSpeed;
+        double _stackRadius;
+        double _stackHeight;
+        double _clearance;
+        double _collisionPenalty;
+        /** Another job lies on top of job */
+        bool stacked(std::size_t job) const;
+        /** Distance to the closest other job in the x-y plane */
+        double neighbourDistance(std::size_t job) const;
+    public:
+        /** linearSpeed, angularSpeed: mean tool speeds of the travel estimate (m/s, rad/s)
+         *  stackRadius, stackHeight: a job closer than stackRadius and higher by stackHeight is on top (m)
+         *  clearance: neighbour distance the gripper needs (m)
+         *  collisionPenalty: added travel time of a job with a closer neighbour (s)
+         */
+        PickQueue(double linearSpeed = 0.3, double angularSpeed = 1.0, double stackRadius = 0.05,
+                  double stackHeight = 0.03, double clearance = 0.1, double collisionPenalty = 2.0);
+        ~PickQueue();
+        void setParam(double linearSpeed, double angularSpeed, double stackRadius,
+                      double stackHeight, double clearance, double collisionPenalty);
+        void clear();
+
+        /** Replace the jobs with a detection of the source time stamp, returns false for stale detections */
+        bool update(const ros::Time &stamp, const std::vector<PickJob> &jobs);
+        /** The last pick ended at time, the remaining jobs wait for a newer detection */
+        void picked(const ros::Time &time);
+        /** Jobs were refreshed by a detection after the last pick */
+        bool validated() const { return _stamp > _pickedAt; }
+
+        /** Estimated travel time of the tool between two poses (s) */
+        double travelTime(const geometry_msgs::Pose &from, const geometry_msgs::Pose &to) const;
+        /** Remove and return the next job for the tool at from */
+        bool next(const geometry_msgs::Pose &from, PickJob &job);
+
+        bool empty() const { return _jobs.empty(); }
+        std::size_t size() const { return _jobs.size(); }
+        const ros::Time &stamp() const { return _stamp; }
+    };
+}
+
+#endif // !_PICK_QUEUE_H
@@ -7,55 +7,102 @@
 #include <control_msgs/GripperCommandAction.h>
 #include <std_msgs/Bool.h>
 
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+
 /** ToDo: 
  * 1. Remove hard coded gripper move position
  * 2. Detect the object that gripped or not 
- *   - By reading the gripper positions
+ *   - By reading the gripper positions (done, closeGripperAsync)
  *   - Or by calculating the effort from the gripper fingers
 */
 
 namespace iwtros{
     class schunkGripper
     {
+    private:
+        std::mutex _promiseLock;
+        // Result of the running command, resolved by the action result
+        std::shared_ptr<std::promise<bool> > _pending;
+        std::shared_future<bool> _sendGoal(double position, bool grasp);
     protected:
         ros::NodeHandle _nh;
         ros::Publisher _pub;
         actionlib::SimpleActionClient<control_msgs::GripperCommandAction> _client;
         control_msgs::GripperCommandGoal _goal;
+        // A closed gripper further open than the command plus this holds an object (m)
+        double _graspMargin = 0.002;
     public:
         schunkGripper(ros::NodeHandle nh);
         ~schunkGripper();
         void closeGripper();
         void openGripper();
         void ackGripper();
+        /** Non blocking commands, the future is true once the fingers are open or closed.
+         * With expectObject a close is only confirmed if an object is held (stalled or stopped
+         * before the command), an empty gripper closing completely is a failed grasp then.
+         */
+        std::shared_future<bool> openGripperAsync();
+        std::shared_future<bool> closeGripperAsync(bool expectObject);
     };
     
-    schunkGripper::schunkGripper(ros::NodeHandle nh) : _client("/iiwa/wsg_50_tcp_driver/wsg50_gripper_action", true), _nh(nh){
+    inline schunkGripper::schunkGripper(ros::NodeHandle nh) : _client("/iiwa/wsg_50_tcp_driver/wsg50_gripper_action", true), _nh(nh){
         bool serverS = _client.waitForServer(ros::Duration(5.0));
         _pub = _nh.advertise<std_msgs::Bool>("ack_griper", 1);
         if(serverS) ROS_INFO("Gripper connection is established");
         else ROS_ERROR("Failed establish connection to gripper action server");
         
     }
-    schunkGripper::~schunkGripper(){}
+    inline schunkGripper::~schunkGripper(){}
+
+    inline std::shared_future<bool> schunkGripper::_sendGoal(double position, bool grasp){
+        std::shared_ptr<std::promise<bool> > promise(new std::promise<bool>());
+        {
+            std::lock_guard<std::mutex> lock(_promiseLock);
+            // A new goal replaces the running one, its result never arrives
+            if(_pending) _pending->set_value(false);
+            _pending = promise;
+        }
+        _goal.command.position = position;
+        const double margin = _graspMargin;
+        _client.sendGoal(_goal, [this, promise, position, grasp, margin](const actionlib::SimpleClientGoalState &state,
+                                                                         const control_msgs::GripperCommandResultConstPtr &result){
+            bool done = state == actionlib::SimpleClientGoalState::SUCCEEDED;
+            // Closing on a box stops the fingers before the commanded width
+            if(grasp) done = result && (result->stalled || result->position > position + margin);
+            std::lock_guard<std::mutex> lock(_promiseLock);
+            if(_pending != promise) return;
+            promise->set_value(done);
+            _pending.reset();
+        });
+        return promise->get_future().share();
+    }
+
+    inline std::shared_future<bool> schunkGripper::openGripperAsync(){
+        return _sendGoal(0.054, false);
+    }
+
+    inline std::shared_future<bool> schunkGripper::closeGripperAsync(bool expectObject){
+        return _sendGoal(0.01, expectObject);
+    }
 
-    void schunkGripper::closeGripper(){
-        _goal.command.position = 0.01;
-        _client.sendGoal(_goal);
-        bool reached = _client.waitForResult(ros::Duration(10.0));
+    inline void schunkGripper::closeGripper(){
+        std::shared_future<bool> result = closeGripperAsync(false);
+        bool reached = result.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
         if(reached) ROS_INFO("Closed Finger");
         else ROS_WARN("Failed Closed Finger");
     }
 
-    void schunkGripper::openGripper(){
-        _goal.command.position = 0.054;
-        _client.sendGoal(_goal);
-        bool reached = _client.waitForResult(ros::Duration(10.0));
+    inline void schunkGripper::openGripper(){
+        std::shared_future<bool> result = openGripperAsync();
+        bool reached = result.wait_for(std::chrono::seconds(10)) == std::future_status::ready && result.get();
         if(reached) ROS_INFO("Opened Finger");
         else ROS_WARN("Failed open Finger");
     }
 
-    void schunkGripper::ackGripper()
+    inline void schunkGripper::ackGripper()
     {
         std_msgs::Bool ack;
         ack.data = true;
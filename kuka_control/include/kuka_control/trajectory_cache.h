@@ -0,0 +1,71 @@
+#ifndef _TRAJECTORY_CACHE_H
+#define _TRAJECTORY_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/Pose.h>
+#include <moveit_msgs/RobotTrajectory.h>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit/planning_scene/planning_scene.h>
+
+namespace iwtros{
+    /** Plans of recurring motions (place, retreat, home).
+     * Entries are keyed on the quantized start joint state, the goal pose and the planner.
+     * A cached trajectory is only reused if the start state is within the start tolerance
+     * and every waypoint is still within the joint limits and collision free in the current scene.
+     */
+    class TrajectoryCache
+    {
+    private:
+        typedef std::vector<long> Key;
+        struct Entry
+        {
+            std::vector<double> start;
+            moveit_msgs::RobotTrajectory trajectory;
+            std::size_t hits;
+            std::size_t order;
+        };
+        std::map<Key, Entry> _entries;
+        double _jointStep;
+        double _positionStep;
+        double _orientationStep;
+        double _startTolerance;
+        std::size_t _capacity;
+        std::size_t _hits, _misses, _stored;
+        Key key(const std::vector<double> &start, const geometry_msgs::Pose &goal, const std::string &planner) const;
+        /** Waypoints within position and velocity limits and collision free */
+        bool valid(const robot_state::RobotState &start, const std::string &group,
+                   const moveit_msgs::RobotTrajectory &trajectory,
+                   const planning_scene::PlanningSceneConstPtr &scene) const;
+    public:
+        /** jointStep: start state quantization (rad)
+         *  positionStep, orientationStep: goal quantization (m, quaternion component)
+         *  startTolerance: largest joint difference to the cached start state (rad)
+         *  capacity: entries kept, the least used and then oldest one is replaced
+         */
+        TrajectoryCache(double jointStep = 0.01, double positionStep = 0.001, double orientationStep = 0.005,
+                        double startTolerance = 0.005, std::size_t capacity = 64);
+        ~TrajectoryCache();
+        void setParam(double jointStep, double positionStep, double orientationStep,
+                      double startTolerance, std::size_t capacity);
+        void clear();
+
+        /** Cached trajectory of group from start to goal that is still valid in scene */
+        bool find(const robot_state::RobotState &start, const std::string &group,
+                  const geometry_msgs::Pose &goal, const std::string &planner,
+                  const planning_scene::PlanningSceneConstPtr &scene,
+                  moveit_msgs::RobotTrajectory &trajectory);
+        /** Store a planned and validated trajectory */
+        void store(const robot_state::RobotState &start, const std::string &group,
+                   const geometry_msgs::Pose &goal, const std::string &planner,
+                   const moveit_msgs::RobotTrajectory &trajectory);
+
+        std::size_t size() const { return _entries.size(); }
+        std::size_t hits() const { return _hits; }
+        std::size_t misses() const { return _misses; }
+    };
+}
+
+#endif // !_TRAJECTORY_CACHE_H
@@ -0,0 +1,77 @@
+#include <kuka_control/conveyor_tracker.h>
+
+#include <limits>
+
+iwtros::ConveyorTracker::ConveyorTracker(std::size_t window, double timeout, double maxJump, double minSpeed){
+        setParam(window, timeout, maxJump, minSpeed);
+        reset();
+}
+
+iwtros::ConveyorTracker::~ConveyorTracker(){}
+
+void iwtros::ConveyorTracker::setParam(std::size_t window, double timeout, double maxJump, double minSpeed){
+        _window = window < 3 ? 3 : window;
+        _timeout = timeout;
+        _maxJump = maxJump;
+        _minSpeed = minSpeed;
+}
+
+void iwtros::ConveyorTracker::reset(){
+        _samples.clear();
+        _mean.setZero();
+        _velocity.setZero();
+        _valid = false;
+}
+
+bool iwtros::ConveyorTracker::update(const ros::Time &stamp, const tf2::Vector3 &position){
+        if(!_samples.empty()){
+                if(stamp <= _samples.back().stamp) return false;
+                // A gap or a jump is a new box on the belt
+                if((stamp - _samples.back().stamp).toSec() > _timeout ||
+                   (predict(stamp) - position).length() > _maxJump) reset();
+        }
+        Sample sample;
+        sample.stamp = stamp;
+        sample.position = position;
+        _samples.push_back(sample);
+        while(_samples.size() > _window) _samples.pop_front();
+        fit();
+        return true;
+}
+
+void iwtros::ConveyorTracker::fit(){
+        // Times relative to the oldest sample keep the sums well conditioned
+        const ros::Time origin = _samples.front().stamp;
+        double meanT = 0;
+        tf2::Vector3 mean(0, 0, 0);
+        for(const Sample &s: _samples){
+                meanT += (s.stamp - origin).toSec();
+                mean += s.position;
+        }
+        meanT /= _samples.size();
+        mean /= static_cast<double>(_samples.size());
+        double stt = 0;
+        tf2::Vector3 stp(0, 0, 0);
+        for(const Sample &s: _samples){
+                const double dt = (s.stamp - origin).toSec() - meanT;
+                stt += dt * dt;
+                stp += (s.position - mean) * dt;
+        }
+        _mean = mean;
+        _meanStamp = origin + ros::Duration(meanT);
+        _valid = _samples.size() >= 3 && stt > 0;
+        if(_valid) _velocity = stp / stt;
+        else _velocity.setZero();
+}
+
+tf2::Vector3 iwtros::ConveyorTracker::predict(const ros::Time &stamp) const{
+        if(_samples.empty()) return tf2::Vector3(0, 0, 0);
+        if(!_valid) return _samples.back().position;
+        if(!moving()) return _mean;
+        return _mean + _velocity * (stamp - _meanStamp).toSec();
+}
+
+double iwtros::ConveyorTracker::distance(const ros::Time &stamp, const tf2::Vector3 &position) const{
+        if(_samples.empty() || (stamp - _samples.back().stamp).toSec() > _timeout) return std::numeric_limits<double>::infinity();
+        return (predict(stamp) - position).length();
+}
@@ -1,6 +1,7 @@
 #include <kuka_control/iiwa_manipulation.h>
 #include <thread>
 #include <iostream>
+#include <limits>
 
 #include <moveit_msgs/Constraints.h>
 #include <shape_msgs/SolidPrimitive.h>
@@ -8,22 +9,32 @@
 #include <moveit_msgs/DisplayTrajectory.h>
 #include <moveit_visual_tools/moveit_visual_tools.h>
 #include <geometry_msgs/Transform.h>
+#include <moveit/robot_state/conversions.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
 
 
-iwtros::iiwaMove::iiwaMove(ros::NodeHandle nh, const std::string planning_group) : schunkGripper(nh), _nh(nh), move_group(planning_group){
+iwtros::iiwaMove::iiwaMove(ros::NodeHandle nh, const std::string planning_group) : schunkGripper(nh), _nh(nh), move_group(planning_group),
+                                                                                        _executor("execute_trajectory", true), _listener(buffer){
         // Initialize the move_group
         // joint model group
         // visual markers
         PLANNING_GROUP = planning_group;
         init(_nh);
-        tf2_ros::TransformListener listener(buffer);
 }
 
 iwtros::iiwaMove::~iiwaMove(){}
 
 void iwtros::iiwaMove::init(ros::NodeHandle nh){
         _loadParam();
-        _sub = nh.subscribe<geometry_msgs::TransformStamped>("/detected_goal", 10, boost::bind(&iiwaMove::callback, this, _1));
+        if(_useTrajectoryCache){
+                // Same scene as move_group for the collision recheck of cached plans
+                _sceneMonitor.reset(new planning_scene_monitor::PlanningSceneMonitor("robot_description"));
+                _sceneMonitor->startSceneMonitor(planning_scene_monitor::PlanningSceneMonitor::MONITORED_PLANNING_SCENE_TOPIC);
+                _sceneMonitor->startStateMonitor();
+                _sceneMonitor->requestPlanningSceneState();
+        }
+        _subscribeDetections();
         _accpSub = nh.subscribe<std_msgs::Bool>("accept_pose", 10, boost::bind(&iiwaMove::acceptCallback, this, _1));
         _initialized = true;
         ready_pick_pose = false;
@@ -39,6 +50,34 @@ void iwtros::iiwaMove::_loadParam(){
         velocityScalling = 0.3;
         accelerationScalling = 0.3;
         // ToDo: input array param goals
+        ros::NodeHandle pnh("~");
+        pnh.param<std::string>("detections_topic", _detectionsTopic, "/box_detector_node/detected_objects");
+        pnh.param("execution_margin", _executionMargin, 5.0);
+        pnh.param("lin_step", _linStep, 0.005);
+        pnh.param("lin_jump_threshold", _linJumpThreshold, 1.5);
+        int window;
+        double timeout, maxJump, minSpeed;
+        pnh.param("conveyor_window", window, 10);
+        pnh.param("conveyor_timeout", timeout, 2.0);
+        pnh.param("conveyor_max_jump", maxJump, 0.1);
+        pnh.param("conveyor_min_speed", minSpeed, 0.005);
+        _conveyor.setParam(window, timeout, maxJump, minSpeed);
+        double linearSpeed, angularSpeed, stackRadius, stackHeight, clearance, collisionPenalty;
+        pnh.param("pick_linear_speed", linearSpeed, 0.3);
+        pnh.param("pick_angular_speed", angularSpeed, 1.0);
+        pnh.param("stack_radius", stackRadius, 0.05);
+        pnh.param("stack_height", stackHeight, 0.03);
+        pnh.param("pick_clearance", clearance, 0.1);
+        pnh.param("collision_penalty", collisionPenalty, 2.0);
+        pnh.param("revalidate_timeout", _revalidateTimeout, 1.0);
+        _picks.setParam(linearSpeed, angularSpeed, stackRadius, stackHeight, clearance, collisionPenalty);
+        int cacheSize;
+        double jointStep, startTolerance;
+        pnh.param("trajectory_cache", _useTrajectoryCache, true);
+        pnh.param("cache_size", cacheSize, 64);
+        pnh.param("cache_joint_step", jointStep, 0.01);
+        pnh.param("cache_start_tolerance", startTolerance, 0.005);
+        _trajectories.setParam(jointStep, 0.001, 0.005, startTolerance, cacheSize);
 }
 
 geometry_msgs::PoseStamped iwtros::iiwaMove::generatePose(double x, double y, double z,
@@ -60,17 +99,128 @@ geometry_msgs::PoseStamped iwtros::iiwaMove::generatePose(double x, double y, do
 }
 
 
+void iwtros::iiwaMove::_subscribeDetections(){
+        // One source only, two detectors would overwrite each other's pick pose and belt samples
+        if(_detectionsTopic.empty())
+                _sub = _nh.subscribe<geometry_msgs::TransformStamped>("/detected_goal", 10, boost::bind(&iiwaMove::callback, this, _1));
+        else
+                _objectsSub = _nh.subscribe<iwtros_msgs::objectDetections>(_detectionsTopic, 5, boost::bind(&iiwaMove::objectsCallback, this, _1));
+}
+
+void iwtros::iiwaMove::_shutdownDetections(){
+        _sub.shutdown();
+        _objectsSub.shutdown();
+}
+
 void iwtros::iiwaMove::callback(const geometry_msgs::TransformStamped::ConstPtr& data){
+    // Sensor time of the detection, not the arrival time
+    _updatePick(data->header.stamp.isZero() ? ros::Time::now() : data->header.stamp, data->transform);
+}
+
+void iwtros::iiwaMove::objectsCallback(const iwtros_msgs::objectDetections::ConstPtr& data){
+    ros::Time stamp = data->header.stamp.isZero() ? ros::Time::now() : data->header.stamp;
+    geometry_msgs::TransformStamped camera;
+    if(!data->objects.empty()){
+        try{
+            camera = buffer.lookupTransform(REFERENCE_FRAME, data->header.frame_id, stamp, ros::Duration(0.1));
+        }catch(tf2::TransformException &ex){
+            ROS_WARN("%s", ex.what());
+            return;
+        }
+    }
+    std::size_t best = 0;
+    std::vector<geometry_msgs::Transform> detections;
+    std::vector<PickJob> jobs;
+    for(std::size_t i = 0; i < data->objects.size(); i++){
+        if(data->objects[i].score > data->objects[best].score) best = i;
+        geometry_msgs::PoseStamped source, target;
+        source.header = data->header;
+        source.pose = data->objects[i].pose;
+        tf2::doTransform(source, target, camera);
+        geometry_msgs::Transform detection;
+        detection.translation.x = target.pose.position.x;
+        detection.translation.y = target.pose.position.y;
+        detection.translation.z = target.pose.position.z;
+        detection.rotation = target.pose.orientation;
+        detections.push_back(detection);
+        PickJob job;
+        job.model_id = data->objects[i].model_id;
+        job.pose = _graspPose(detection).pose;
+        job.score = data->objects[i].score;
+        jobs.push_back(job);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_detectionLock);
+        _picks.update(stamp, jobs);
+    }
+    if(detections.empty()) return;
+    ROS_DEBUG("Best %s of %zu instances, score %f, latency %f s", data->objects[best].model_id.c_str(),
+              data->objects.size(), data->objects[best].score, data->latency.toSec());
+    // The belt tracker follows one box, the best score may jump to another box between frames
+    std::size_t tracked = best;
+    {
+        std::lock_guard<std::mutex> lock(_detectionLock);
+        double closest = std::numeric_limits<double>::infinity();
+        for(std::size_t i = 0; i < detections.size(); i++){
+            const double d = _conveyor.distance(stamp, tf2::Vector3(detections[i].translation.x, detections[i].translation.y,
+                                                                     detections[i].translation.z));
+            if(d < closest){
+                closest = d;
+                tracked = i;
+            }
+        }
+    }
+    _updatePick(stamp, detections[tracked]);
+}
+
+geometry_msgs::PoseStamped iwtros::iiwaMove::_graspPose(const geometry_msgs::Transform &detection){
     tf2Scalar roll, pitch, yaw;
     tf2::Quaternion q;
-    tf2::fromMsg(data->transform.rotation, q);
+    tf2::fromMsg(detection.rotation, q);
     tf2::Matrix3x3 mat(q);
     mat.getEulerYPR(yaw, pitch, roll);
-    this->pick_pose = generatePose(data->transform.translation.x, data->transform.translation.y, 
-                                   1.125 + data->transform.translation.z, M_PI, 0, yaw + M_PI/4, "iiwa_link_0");
+    return generatePose(detection.translation.x, detection.translation.y, 
+                        1.125 + detection.translation.z, M_PI, 0, yaw + M_PI/4, "iiwa_link_0");
+}
+
+void iwtros::iiwaMove::_updatePick(const ros::Time &stamp, const geometry_msgs::Transform &detection){
+    geometry_msgs::PoseStamped pose = _graspPose(detection);
+    std::lock_guard<std::mutex> lock(_detectionLock);
+    _conveyor.update(stamp, tf2::Vector3(detection.translation.x, detection.translation.y,
+                                         detection.translation.z));
+    this->pick_pose = pose;
     this->ready_pick_pose = true;
 }
 
+bool iwtros::iiwaMove::_revalidatePicks(){
+        const ros::Time deadline = ros::Time::now() + ros::Duration(_revalidateTimeout);
+        while(ros::ok() && ros::Time::now() < deadline){
+                {
+                        std::lock_guard<std::mutex> lock(_detectionLock);
+                        if(_picks.validated()) return true;
+                }
+                ros::Duration(0.05).sleep();
+        }
+        return false;
+}
+
+bool iwtros::iiwaMove::_queuedPicks(){
+        std::lock_guard<std::mutex> lock(_detectionLock);
+        return !_picks.empty();
+}
+
+geometry_msgs::PoseStamped iwtros::iiwaMove::predictPickPose(const ros::Time &graspTime){
+        std::lock_guard<std::mutex> lock(_detectionLock);
+        geometry_msgs::PoseStamped pose = this->pick_pose;
+        if(!_conveyor.moving()) return pose;
+        tf2::Vector3 position = _conveyor.predict(graspTime);
+        ROS_INFO("Belt %.3f m/s, box moves %.3f m until the grasp", _conveyor.velocity().length(),
+                 (position - _conveyor.predict(_conveyor.lastStamp())).length());
+        pose.pose.position.x = position.x();
+        pose.pose.position.y = position.y();
+        return pose;
+}
+
 void iwtros::iiwaMove::acceptCallback(const std_msgs::Bool::ConstPtr &data)
 {
     this->_accept_pose = data->data;
@@ -107,10 +257,11 @@ void iwtros::iiwaMove::_ctrl_loop(){
         // ToDo: Check asynchronous spinner is required
         ros::spinOnce();
         bool home_position = true;
+        // Fixed goals, the same poses every cycle keep the trajectory cache hitting
+        const geometry_msgs::PoseStamped place_pose = generatePose(0.228, -0.428, 1.24, M_PI, 0 , M_PI/4 + M_PI/2, "iiwa_link_0");
+        const geometry_msgs::PoseStamped home_pose = generatePose(0.228, 0.428, 1.3, M_PI, 0 , M_PI/4 + M_PI/2, "iiwa_link_0");
+        const geometry_msgs::PoseStamped test_pose = generatePose(0.6, 0.09, 1.12, M_PI, 0 , M_PI/4 + M_PI/2, "iiwa_link_0");
         while(ros::ok()){
-                geometry_msgs::PoseStamped place_pose = generatePose(0.228, -0.428, 1.24, M_PI, 0 , M_PI/4 + M_PI/2, "iiwa_link_0");
-                geometry_msgs::PoseStamped home_pose = generatePose(0.228, 0.428, 1.3, M_PI, 0 , M_PI/4 + M_PI/2, "iiwa_link_0");
-                geometry_msgs::PoseStamped test_pose = generatePose(0.6, 0.09, 1.12, M_PI, 0 , M_PI/4 + M_PI/2, "iiwa_link_0");
                 _plcKUKA.ConveyorPlaced = false;
                 _plcKUKA.DHBWPlaced = false;
                 _plcKUKA.ReachedHome = false;
@@ -118,27 +269,59 @@ void iwtros::iiwaMove::_ctrl_loop(){
                 if(ready_pick_pose && _accept_pose && _plcSubscriberControl.ConveyorPickPose){
                         ready_pick_pose = false;
                         _accept_pose = false;
-                        _sub.shutdown();
+                        // Where the box is now, executeSegments moves the goals to the planned arrival
+                        geometry_msgs::PoseStamped pick = predictPickPose(ros::Time::now());
+                        _shutdownDetections();
                         ROS_WARN("Moving to Pick");
-                        pnpPipeLine(this->pick_pose, place_pose, 0.15);
+                        const bool placed = pnpPipeLine(pick, place_pose, 0.15, true);
                         home_position = true;
-                        _sub = _nh.subscribe<geometry_msgs::TransformStamped>("/detected_goal", 10, boost::bind(&iiwaMove::callback, this, _1)); 
+                        _subscribeDetections();
                         _plcKUKA.ConveyorPlaced = false;
                         _plcKUKA.ReachedHome = false;
-                        _plcKUKA.DHBWPlaced = true;
+                        _plcKUKA.DHBWPlaced = placed;
                         _plcPub.publish(_plcKUKA);
                 }
-                if(ready_pick_pose && _accept_pose && _plcSubscriberControl.DHBWPickPose){
+                if((ready_pick_pose || _queuedPicks()) && _accept_pose && _plcSubscriberControl.DHBWPickPose){
                         ready_pick_pose = false;
-                        _accept_pose = false;
-                        _sub.shutdown();
+                        // Shortest travel from the current tool pose among the boxes that are free to pick
+                        const geometry_msgs::Pose tool = move_group.getCurrentPose(EE_FRAME).pose;
+                        geometry_msgs::PoseStamped pick = this->pick_pose;
+                        {
+                                std::lock_guard<std::mutex> lock(_detectionLock);
+                                PickJob job;
+                                if(_picks.next(tool, job)){
+                                        pick.header.frame_id = REFERENCE_FRAME;
+                                        pick.pose = job.pose;
+                                        ROS_INFO("Picking %s, %zu more in the queue", job.model_id.c_str(), _picks.size());
+                                }
+                        }
+                        _shutdownDetections();
                         ROS_WARN("Moving to Pick");
-                        pnpPipeLine(this->pick_pose, place_pose, 0.15);
+                        const bool placed = pnpPipeLine(pick, place_pose, 0.15);
                         home_position = true;
-                        _sub = _nh.subscribe<geometry_msgs::TransformStamped>("/detected_goal", 10, boost::bind(&iiwaMove::callback, this, _1)); 
+                        if(placed){
+                                std::lock_guard<std::mutex> lock(_detectionLock);
+                                _picks.picked(ros::Time::now());
+                        }
+                        _subscribeDetections();
+                        // The remaining boxes are confirmed by the next detection, no new detection cycle.
+                        // After a failed pick or without a confirming detection the scene is unknown,
+                        // the queue is dropped and a new detection has to be accepted
+                        bool retry = !placed;
+                        if(retry) ROS_WARN("Pick failed, waiting for a new accept");
+                        else if(!_queuedPicks()) _accept_pose = false;
+                        else if(!_revalidatePicks()){
+                                ROS_WARN("No detection after the pick, waiting for a new accept");
+                                retry = true;
+                        }
+                        if(retry){
+                                std::lock_guard<std::mutex> lock(_detectionLock);
+                                _picks.clear();
+                                _accept_pose = false;
+                        }
                         _plcKUKA.DHBWPlaced = false;
                         _plcKUKA.ReachedHome = false;
-                        _plcKUKA.ConveyorPlaced = true;
+                        _plcKUKA.ConveyorPlaced = placed;
                         _plcPub.publish(_plcKUKA);
                 }
                 if(_plcSubscriberControl.MoveHome){
@@ -160,50 +343,200 @@ void iwtros::iiwaMove::_ctrl_loop(){
         }
 }
 
-void iwtros::iiwaMove::pnpPipeLine(geometry_msgs::PoseStamped pick,
+bool iwtros::iiwaMove::pnpPipeLine(geometry_msgs::PoseStamped pick,
                         geometry_msgs::PoseStamped place,
-                        const double offset){
-        // Go to Pick prepose (PTP)
-        pick.pose.position.z += offset;
-        motionExecution(pick);
-        this->openGripper();
-        // Go to Pick pose, ToDo: Set LIN motion
-        pick.pose.position.z -= offset;
-        motionExecution(pick);
-        this->closeGripper();
-        ros::Duration(1.0).sleep();
-        // Go to Pick Postpose, ToDo: Set LIN motion
-        pick.pose.position.z += offset;
-        motionExecution(pick);
-        // Go to Place Prepose (PTP)
-        place.pose.position.z += offset;
-        motionExecution(place);
-        // Go to Place pose, ToDo: Set LIN motion
-        place.pose.position.z -= offset;
-        motionExecution(place);
-        this->openGripper();
-        ros::Duration(0.5).sleep();
-        // Go to Place Postpose, ToDo: Set LIN motion
-        place.pose.position.z += offset;
-        motionExecution(place);
-        this->closeGripper();
-        ros::Duration(1.0).sleep();
+                        const double offset, bool conveyor){
+        std::vector<MotionSegment> segments(6);
+        // Pick prepose (PTP)
+        segments[0].pose = pick;
+        segments[0].pose.pose.position.z += offset;
+        segments[0].gripper = MotionSegment::OPEN;
+        segments[0].early = true;
+        // Pick pose (LIN), on the belt it catches up with the box from the pre pose
+        segments[1].pose = pick;
+        segments[1].linear = true;
+        segments[1].gripper = MotionSegment::CLOSE;
+        segments[1].grasp = true;
+        segments[1].track = conveyor;
+        // Pick Postpose (LIN)
+        segments[2].pose = segments[0].pose;
+        segments[2].linear = true;
+        // Place Prepose (PTP)
+        segments[3].pose = place;
+        segments[3].pose.pose.position.z += offset;
+        // Place pose (LIN)
+        segments[4].pose = place;
+        segments[4].linear = true;
+        segments[4].gripper = MotionSegment::OPEN;
+        // Place Postpose (LIN)
+        segments[5].pose = segments[3].pose;
+        segments[5].linear = true;
+        segments[5].gripper = MotionSegment::CLOSE;
+        const bool placed = executeSegments(segments);
         this->ackGripper();
-        ros::Duration(1.0).sleep();
-        this->closeGripper();
+        if(!placed){
+                // The sequence stopped before segment 5 closed the gripper
+                ROS_ERROR("Pick and place incomplete");
+                // The acknowledge is a plain topic without a result, give the driver time to reset
+                ros::Duration(1.0).sleep();
+                this->closeGripper();
+        }
+        return placed;
+}
+
+void iwtros::iiwaMove::_followBelt(std::vector<MotionSegment> &segments, std::size_t k, const robot_state::RobotState &start){
+        std::size_t tracked = k;
+        while(tracked < segments.size() && tracked <= k + 1 && !segments[tracked].track) tracked++;
+        if(tracked >= segments.size() || !segments[tracked].track) return;
+        // Arrival at the grasp from the plans to the last prediction, a few cm on the belt hardly change the durations
+        ros::Duration arrival(0);
+        robot_state::RobotState from(start);
+        for(std::size_t j = k; j <= tracked; j++){
+                moveit::planning_interface::MoveGroupInterface::Plan plan;
+                if(!planSegment(segments[j].pose, from, plan, segments[j].linear)) return;
+                const trajectory_msgs::JointTrajectory &path = plan.trajectory_.joint_trajectory;
+                if(path.points.empty()) continue;
+                arrival += path.points.back().time_from_start;
+                from.setVariablePositions(path.joint_names, path.points.back().positions);
+                from.update();
+        }
+        geometry_msgs::PoseStamped grasp = predictPickPose(ros::Time::now() + arrival);
+        const double dx = grasp.pose.position.x - segments[tracked].pose.pose.position.x;
+        const double dy = grasp.pose.position.y - segments[tracked].pose.pose.position.y;
+        ROS_DEBUG("Grasp in %f s, goals shifted by (%f, %f)", arrival.toSec(), dx, dy);
+        for(std::size_t j = k; j < segments.size() && j <= tracked + 1; j++){
+                segments[j].pose.pose.position.x += dx;
+                segments[j].pose.pose.position.y += dy;
+        }
+}
+
+bool iwtros::iiwaMove::executeSegments(std::vector<MotionSegment> segments){
+        typedef moveit::planning_interface::MoveGroupInterface::Plan Plan;
+        robot_state::RobotStatePtr current = move_group.getCurrentState();
+        if(!current){
+                ROS_ERROR("No current robot state, pick and place skipped");
+                return false;
+        }
+        bool grasped = true;
+        robot_state::RobotState start(*current);
+        Plan plan;
+        bool planned = false;
+        for(std::size_t k = 0; k < segments.size(); k++){
+                if(!planned){
+                        // First segment, a tracked goal or a failed plan ahead: plan from where the arm is
+                        current = move_group.getCurrentState();
+                        if(current) start = *current;
+                        if(current) _followBelt(segments, k, start);
+                        planned = current && planSegment(segments[k].pose, start, plan, segments[k].linear);
+                }
+                if(!planned){
+                        // Gripper commands and the remaining segments need the arm at this goal
+                        ROS_ERROR("Segment %zu could not be planned, sequence aborted", k);
+                        return false;
+                }
+                moveit_msgs::ExecuteTrajectoryGoal goal;
+                goal.trajectory = plan.trajectory_;
+                _executor.sendGoal(goal);
+                std::shared_future<bool> gripper;
+                if(segments[k].early && segments[k].gripper == MotionSegment::OPEN) gripper = this->openGripperAsync();
+                else if(segments[k].early && segments[k].gripper == MotionSegment::CLOSE) gripper = this->closeGripperAsync(segments[k].grasp);
+                // Plan ahead from the goal state of this segment while the arm moves
+                Plan next;
+                bool nextPlanned = false;
+                robot_state::RobotState end(start);
+                const trajectory_msgs::JointTrajectory &path = plan.trajectory_.joint_trajectory;
+                if(!path.points.empty() && k + 1 < segments.size() && !segments[k + 1].track){
+                        end.setVariablePositions(path.joint_names, path.points.back().positions);
+                        end.update();
+                        nextPlanned = planSegment(segments[k + 1].pose, end, next, segments[k + 1].linear);
+                }
+                const ros::Duration duration = path.points.empty() ? ros::Duration(0) : path.points.back().time_from_start;
+                if(!_executor.waitForResult(duration + ros::Duration(_executionMargin))){
+                        ROS_ERROR("Segment %zu did not finish within %.1f s, sequence aborted", k,
+                                  (duration + ros::Duration(_executionMargin)).toSec());
+                        _executor.cancelGoal();
+                        return false;
+                }
+                if(_executor.getState() != actionlib::SimpleClientGoalState::SUCCEEDED){
+                        // No gripper command away from the goal
+                        ROS_ERROR("Segment %zu failed: %s, sequence aborted", k, _executor.getState().toString().c_str());
+                        return false;
+                }
+                if(!segments[k].early && segments[k].gripper == MotionSegment::OPEN) gripper = this->openGripperAsync();
+                else if(!segments[k].early && segments[k].gripper == MotionSegment::CLOSE) gripper = this->closeGripperAsync(segments[k].grasp);
+                // The action result confirms the gripper, no fixed sleep
+                bool confirmed = true;
+                if(gripper.valid()){
+                        confirmed = gripper.wait_for(std::chrono::seconds(10)) == std::future_status::ready && gripper.get();
+                        if(!confirmed) ROS_WARN("Gripper not confirmed after segment %zu", k);
+                }
+                if(!grasped) return false;
+                // Lift the empty gripper and stop
+                if(segments[k].grasp && !confirmed) grasped = false;
+                start = end;
+                plan = next;
+                planned = nextPlanned;
+        }
+        return grasped;
+}
+
+bool iwtros::iiwaMove::planSegment(const geometry_msgs::PoseStamped &pose, const robot_state::RobotState &start,
+                                   moveit::planning_interface::MoveGroupInterface::Plan &plan, bool linear){
+        bool eCode = false;
+        const std::string planner = linear ? "LIN" : PLANNER_ID;
+        if(_useTrajectoryCache){
+                planning_scene_monitor::LockedPlanningSceneRO scene(_sceneMonitor);
+                eCode = _trajectories.find(start, PLANNING_GROUP, pose.pose, planner, scene, plan.trajectory_);
+                if(eCode) ROS_INFO_NAMED("PLAN", "Cached trajectory, %zu hits %zu misses", _trajectories.hits(), _trajectories.misses());
+        }
+        if(!eCode && linear){
+                eCode = planLinear(pose, start, plan);
+                if(eCode && _useTrajectoryCache) _trajectories.store(start, PLANNING_GROUP, pose.pose, planner, plan.trajectory_);
+                // Blocked straight line, the constrained PTP planner may still find a way
+                if(!eCode) ROS_WARN_NAMED("PLAN", "LIN motion incomplete, falling back to %s", PLANNER_ID.c_str());
+        }
+        if(!eCode){
+                move_group.setStartState(start);
+                motionContraints(pose);
+                move_group.setPoseTarget(pose);
+                // ToDo: Valide the IK solution
+                eCode = (move_group.plan(plan) == moveit::planning_interface::MoveItErrorCode::SUCCESS);
+                ROS_ERROR_STREAM_NAMED("PLAN","Motion planning is: " << (eCode?"Success":"Failed"));
+                if(eCode && _useTrajectoryCache) _trajectories.store(start, PLANNING_GROUP, pose.pose, PLANNER_ID, plan.trajectory_);
+                move_group.setStartStateToCurrentState();
+                move_group.clearTrajectoryConstraints();
+                move_group.clearPoseTarget();
+        }
+        moveit::core::robotStateToRobotStateMsg(start, plan.start_state_);
+        visualMarkers(pose, plan);
+        return eCode;
+}
+
+bool iwtros::iiwaMove::planLinear(const geometry_msgs::PoseStamped &pose, const robot_state::RobotState &start,
+                                  moveit::planning_interface::MoveGroupInterface::Plan &plan){
+        move_group.setStartState(start);
+        std::vector<geometry_msgs::Pose> waypoints(1, pose.pose);
+        moveit_msgs::RobotTrajectory path;
+        const double fraction = move_group.computeCartesianPath(waypoints, _linStep, _linJumpThreshold, path);
+        move_group.setStartStateToCurrentState();
+        if(fraction < 1.0) return false;
+        // Same speed limits as the PTP motions
+        robot_trajectory::RobotTrajectory trajectory(start.getRobotModel(), PLANNING_GROUP);
+        trajectory.setRobotTrajectoryMsg(start, path);
+        trajectory_processing::IterativeParabolicTimeParameterization timing;
+        if(!timing.computeTimeStamps(trajectory, velocityScalling, accelerationScalling)) return false;
+        trajectory.getRobotTrajectoryMsg(plan.trajectory_);
+        return true;
 }
 
 void iwtros::iiwaMove::motionExecution(const geometry_msgs::PoseStamped pose){
-        motionContraints(pose);
-        move_group.setPoseTarget(pose);
-        // ToDo: Valide the IK solution
+        robot_state::RobotStatePtr start = move_group.getCurrentState();
+        if(!start){
+                ROS_ERROR("No current robot state, motion skipped");
+                return;
+        }
         moveit::planning_interface::MoveGroupInterface::Plan mPlan;
-        bool eCode = (move_group.plan(mPlan) == moveit::planning_interface::MoveItErrorCode::SUCCESS);
-        ROS_ERROR_STREAM_NAMED("PLAN","Motion planning is: " << eCode?"Success":"Failed");
-        visualMarkers(pose, mPlan);
-        if(eCode) move_group.execute(mPlan);
-        move_group.clearTrajectoryConstraints();
-        move_group.clearPoseTarget();
+        if(planSegment(pose, *start, mPlan)) move_group.execute(mPlan);
 }
 
 void iwtros::iiwaMove::motionContraints(const geometry_msgs::PoseStamped pose){
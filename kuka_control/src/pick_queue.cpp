@@ -0,0 +1,93 @@
+#include <kuka_control/pick_queue.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <tf2/LinearMath/Quaternion.h>
+
+iwtros::PickQueue::PickQueue(double linearSpeed, double angularSpeed, double stackRadius,
+                             double stackHeight, double clearance, double collisionPenalty){
+        setParam(linearSpeed, angularSpeed, stackRadius, stackHeight, clearance, collisionPenalty);
+}
+
+iwtros::PickQueue::~PickQueue(){}
+
+void iwtros::PickQueue::setParam(double linearSpeed, double angularSpeed, double stackRadius,
+                                 double stackHeight, double clearance, double collisionPenalty){
+        _linearSpeed = linearSpeed;
+        _angularSpeed = angularSpeed;
+        _stackRadius = stackRadius;
+        _stackHeight = stackHeight;
+        _clearance = clearance;
+        _collisionPenalty = collisionPenalty;
+}
+
+void iwtros::PickQueue::clear(){
+        _jobs.clear();
+}
+
+bool iwtros::PickQueue::update(const ros::Time &stamp, const std::vector<PickJob> &jobs){
+        if(stamp <= _pickedAt || stamp < _stamp) return false;
+        _jobs = jobs;
+        _stamp = stamp;
+        return true;
+}
+
+void iwtros::PickQueue::picked(const ros::Time &time){
+        _pickedAt = time;
+}
+
+double iwtros::PickQueue::travelTime(const geometry_msgs::Pose &from, const geometry_msgs::Pose &to) const{
+        const double dx = to.position.x - from.position.x;
+        const double dy = to.position.y - from.position.y;
+        const double dz = to.position.z - from.position.z;
+        tf2::Quaternion qFrom(from.orientation.x, from.orientation.y, from.orientation.z, from.orientation.w);
+        tf2::Quaternion qTo(to.orientation.x, to.orientation.y, to.orientation.z, to.orientation.w);
+        // PTP moves all joints together, the slower of translation and rotation dominates
+        const double linear = std::sqrt(dx * dx + dy * dy + dz * dz) / _linearSpeed;
+        const double angular = qFrom.normalized().angleShortestPath(qTo.normalized()) / _angularSpeed;
+        return std::max(linear, angular);
+}
+
+bool iwtros::PickQueue::stacked(std::size_t job) const{
+        const geometry_msgs::Point &p = _jobs[job].pose.position;
+        for(std::size_t i = 0; i < _jobs.size(); i++){
+                if(i == job) continue;
+                const geometry_msgs::Point &q = _jobs[i].pose.position;
+                if(std::hypot(q.x - p.x, q.y - p.y) < _stackRadius && q.z - p.z > _stackHeight) return true;
+        }
+        return false;
+}
+
+double iwtros::PickQueue::neighbourDistance(std::size_t job) const{
+        const geometry_msgs::Point &p = _jobs[job].pose.position;
+        double closest = std::numeric_limits<double>::infinity();
+        for(std::size_t i = 0; i < _jobs.size(); i++){
+                if(i == job) continue;
+                const geometry_msgs::Point &q = _jobs[i].pose.position;
+                closest = std::min(closest, std::hypot(q.x - p.x, q.y - p.y));
+        }
+        return closest;
+}
+
+bool iwtros::PickQueue::next(const geometry_msgs::Pose &from, PickJob &job){
+        if(_jobs.empty()) return false;
+        std::size_t best = 0;
+        double bestCost = std::numeric_limits<double>::infinity();
+        bool bestFree = false;
+        for(std::size_t i = 0; i < _jobs.size(); i++){
+                const bool free = !stacked(i);
+                double cost = travelTime(from, _jobs[i].pose);
+                if(neighbourDistance(i) < _clearance) cost += _collisionPenalty;
+                // A free job always beats a covered one
+                if((free && !bestFree) || (free == bestFree && cost < bestCost)){
+                        best = i;
+                        bestCost = cost;
+                        bestFree = free;
+                }
+        }
+        job = _jobs[best];
+        _jobs.erase(_jobs.begin() + best);
+        return true;
+}
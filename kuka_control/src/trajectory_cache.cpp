@@ -0,0 +1,108 @@
+#include <kuka_control/trajectory_cache.h>
+
+#include <cmath>
+#include <functional>
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+iwtros::TrajectoryCache::TrajectoryCache(double jointStep, double positionStep, double orientationStep,
+                                         double startTolerance, std::size_t capacity) : _hits(0), _misses(0), _stored(0){
+        setParam(jointStep, positionStep, orientationStep, startTolerance, capacity);
+}
+
+iwtros::TrajectoryCache::~TrajectoryCache(){}
+
+void iwtros::TrajectoryCache::setParam(double jointStep, double positionStep, double orientationStep,
+                                       double startTolerance, std::size_t capacity){
+        _jointStep = jointStep;
+        _positionStep = positionStep;
+        _orientationStep = orientationStep;
+        _startTolerance = startTolerance;
+        _capacity = capacity < 1 ? 1 : capacity;
+        clear();
+}
+
+void iwtros::TrajectoryCache::clear(){
+        _entries.clear();
+}
+
+iwtros::TrajectoryCache::Key iwtros::TrajectoryCache::key(const std::vector<double> &start, const geometry_msgs::Pose &goal,
+                                                          const std::string &planner) const{
+        Key k;
+        k.reserve(start.size() + 8);
+        k.push_back(static_cast<long>(std::hash<std::string>()(planner)));
+        for(double q: start) k.push_back(std::lround(q / _jointStep));
+        k.push_back(std::lround(goal.position.x / _positionStep));
+        k.push_back(std::lround(goal.position.y / _positionStep));
+        k.push_back(std::lround(goal.position.z / _positionStep));
+        // q and -q are the same goal
+        const double sign = goal.orientation.w < 0 ? -1.0 : 1.0;
+        k.push_back(std::lround(sign * goal.orientation.x / _orientationStep));
+        k.push_back(std::lround(sign * goal.orientation.y / _orientationStep));
+        k.push_back(std::lround(sign * goal.orientation.z / _orientationStep));
+        k.push_back(std::lround(sign * goal.orientation.w / _orientationStep));
+        return k;
+}
+
+bool iwtros::TrajectoryCache::valid(const robot_state::RobotState &start, const std::string &group,
+                                    const moveit_msgs::RobotTrajectory &trajectory,
+                                    const planning_scene::PlanningSceneConstPtr &scene) const{
+        robot_trajectory::RobotTrajectory path(start.getRobotModel(), group);
+        path.setRobotTrajectoryMsg(start, trajectory);
+        const robot_model::JointModelGroup *jmg = start.getJointModelGroup(group);
+        if(!jmg || path.empty()) return false;
+        for(std::size_t i = 0; i < path.getWayPointCount(); i++){
+                const robot_state::RobotState &waypoint = path.getWayPoint(i);
+                if(!waypoint.satisfiesBounds(jmg)) return false;
+                if(!waypoint.hasVelocities()) continue;
+                for(const robot_model::JointModel *joint: jmg->getActiveJointModels())
+                        if(!joint->satisfiesVelocityBounds(waypoint.getJointVelocities(joint))) return false;
+        }
+        // Objects may have been added to the scene since the trajectory was planned
+        return scene->isPathValid(path, group);
+}
+
+bool iwtros::TrajectoryCache::find(const robot_state::RobotState &start, const std::string &group,
+                                   const geometry_msgs::Pose &goal, const std::string &planner,
+                                   const planning_scene::PlanningSceneConstPtr &scene,
+                                   moveit_msgs::RobotTrajectory &trajectory){
+        std::vector<double> joints;
+        start.copyJointGroupPositions(group, joints);
+        std::map<Key, Entry>::iterator it = _entries.find(key(joints, goal, planner));
+        if(it == _entries.end()){
+                _misses++;
+                return false;
+        }
+        // Neighbouring states may share a bin, the controller only accepts a close start
+        bool close = it->second.start.size() == joints.size();
+        for(std::size_t i = 0; close && i < joints.size(); i++)
+                close = std::fabs(it->second.start[i] - joints[i]) <= _startTolerance;
+        if(!close || !valid(start, group, it->second.trajectory, scene)){
+                _misses++;
+                return false;
+        }
+        it->second.hits++;
+        _hits++;
+        trajectory = it->second.trajectory;
+        return true;
+}
+
+void iwtros::TrajectoryCache::store(const robot_state::RobotState &start, const std::string &group,
+                                    const geometry_msgs::Pose &goal, const std::string &planner,
+                                    const moveit_msgs::RobotTrajectory &trajectory){
+        std::vector<double> joints;
+        start.copyJointGroupPositions(group, joints);
+        const Key k = key(joints, goal, planner);
+        if(_entries.size() >= _capacity && _entries.find(k) == _entries.end()){
+                std::map<Key, Entry>::iterator least = _entries.begin();
+                for(std::map<Key, Entry>::iterator it = _entries.begin(); it != _entries.end(); ++it)
+                        if(it->second.hits < least->second.hits ||
+                           (it->second.hits == least->second.hits && it->second.order < least->second.order)) least = it;
+                _entries.erase(least);
+        }
+        Entry &entry = _entries[k];
+        entry.start = joints;
+        entry.trajectory = trajectory;
+        entry.hits = 0;
+        entry.order = _stored++;
+}
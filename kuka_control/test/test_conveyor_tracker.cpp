@@ -0,0 +1,54 @@
+#include <kuka_control/conveyor_tracker.h>
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+namespace{
+        /** Box moving along x with 0.1 m/s, one detection every 0.1 s from t = 1 s */
+        void feedBelt(iwtros::ConveyorTracker &tracker, int detections, double y = 0.0){
+                for(int i = 0; i < detections; i++){
+                        const double t = 1.0 + 0.1 * i;
+                        tracker.update(ros::Time(t), tf2::Vector3(0.4 + 0.1 * (t - 1.0), y, 0.05));
+                }
+        }
+}
+
+TEST(ConveyorTracker, ConstantVelocity){
+        iwtros::ConveyorTracker tracker;
+        feedBelt(tracker, 2);
+        EXPECT_FALSE(tracker.valid());
+        feedBelt(tracker, 5);
+        ASSERT_TRUE(tracker.valid());
+        EXPECT_TRUE(tracker.moving());
+        EXPECT_NEAR(tracker.velocity().x(), 0.1, 1e-6);
+        EXPECT_NEAR(tracker.velocity().y(), 0.0, 1e-6);
+        // One second after the last detection at t = 1.4 s
+        const tf2::Vector3 p = tracker.predict(ros::Time(2.4));
+        EXPECT_NEAR(p.x(), 0.54, 1e-6);
+        EXPECT_NEAR(p.y(), 0.0, 1e-6);
+}
+
+TEST(ConveyorTracker, ClosestDetection){
+        iwtros::ConveyorTracker tracker;
+        EXPECT_TRUE(std::isinf(tracker.distance(ros::Time(1.0), tf2::Vector3(0.4, 0.0, 0.05))));
+        feedBelt(tracker, 5);
+        // The tracked box moved on to x = 0.45, the next box on the belt is 0.2 m behind
+        const double same = tracker.distance(ros::Time(1.5), tf2::Vector3(0.45, 0.0, 0.05));
+        const double next = tracker.distance(ros::Time(1.5), tf2::Vector3(0.25, 0.0, 0.05));
+        EXPECT_NEAR(same, 0.0, 1e-6);
+        EXPECT_LT(same, next);
+        // After the timeout every detection starts a new track
+        EXPECT_TRUE(std::isinf(tracker.distance(ros::Time(5.0), tf2::Vector3(0.45, 0.0, 0.05))));
+}
+
+TEST(ConveyorTracker, JumpRestarts){
+        iwtros::ConveyorTracker tracker;
+        feedBelt(tracker, 5);
+        ASSERT_TRUE(tracker.valid());
+        // Another box further than maxJump from the prediction
+        EXPECT_TRUE(tracker.update(ros::Time(1.5), tf2::Vector3(0.25, 0.0, 0.05)));
+        EXPECT_FALSE(tracker.valid());
+        EXPECT_NEAR(tracker.predict(ros::Time(2.0)).x(), 0.25, 1e-6);
+        // Repeated stamps are rejected
+        EXPECT_FALSE(tracker.update(ros::Time(1.5), tf2::Vector3(0.25, 0.0, 0.05)));
+}
@@ -0,0 +1,105 @@
+#include <kuka_control/pick_queue.h>
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace{
+        iwtros::PickJob job(const std::string &id, double x, double y, double z){
+                iwtros::PickJob j;
+                j.model_id = id;
+                j.pose.position.x = x;
+                j.pose.position.y = y;
+                j.pose.position.z = z;
+                j.pose.orientation.w = 1.0;
+                j.score = 1.0f;
+                return j;
+        }
+
+        geometry_msgs::Pose pose(double x, double y, double z){
+                return job("", x, y, z).pose;
+        }
+
+        /** Model ids in pick order, the tool moves to every picked box */
+        std::vector<std::string> order(iwtros::PickQueue &queue, geometry_msgs::Pose from){
+                std::vector<std::string> ids;
+                iwtros::PickJob j;
+                while(queue.next(from, j)){
+                        ids.push_back(j.model_id);
+                        from = j.pose;
+                }
+                return ids;
+        }
+}
+
+TEST(PickQueue, NearestFirst){
+        iwtros::PickQueue queue;
+        std::vector<iwtros::PickJob> jobs;
+        jobs.push_back(job("far", 0.8, 0.3, 1.2));
+        jobs.push_back(job("mid", 0.5, 0.0, 1.2));
+        jobs.push_back(job("near", 0.3, 0.0, 1.2));
+        ASSERT_TRUE(queue.update(ros::Time(1.0), jobs));
+        EXPECT_EQ(queue.size(), 3u);
+        const std::vector<std::string> expected = {"near", "mid", "far"};
+        EXPECT_EQ(order(queue, pose(0.2, 0.0, 1.3)), expected);
+        EXPECT_TRUE(queue.empty());
+}
+
+TEST(PickQueue, StackedBoxDeferred){
+        iwtros::PickQueue queue;
+        std::vector<iwtros::PickJob> jobs;
+        // bottom is closer to the tool but top lies on it
+        jobs.push_back(job("bottom", 0.3, 0.0, 1.2));
+        jobs.push_back(job("top", 0.31, 0.0, 1.35));
+        ASSERT_TRUE(queue.update(ros::Time(1.0), jobs));
+        const std::vector<std::string> expected = {"top", "bottom"};
+        EXPECT_EQ(order(queue, pose(0.2, 0.0, 1.2)), expected);
+}
+
+TEST(PickQueue, ClearancePenalty){
+        iwtros::PickQueue queue;
+        std::vector<iwtros::PickJob> jobs;
+        // Both close ones are within the gripper clearance of each other
+        jobs.push_back(job("far", 0.8, 0.3, 1.2));
+        jobs.push_back(job("near", 0.3, 0.0, 1.2));
+        jobs.push_back(job("nearB", 0.35, 0.0, 1.2));
+        ASSERT_TRUE(queue.update(ros::Time(1.0), jobs));
+        iwtros::PickJob next;
+        ASSERT_TRUE(queue.next(pose(0.2, 0.0, 1.3), next));
+        EXPECT_EQ(next.model_id, "far");
+
+        // Without penalty the travel time alone decides
+        iwtros::PickQueue free(0.3, 1.0, 0.05, 0.03, 0.1, 0.0);
+        ASSERT_TRUE(free.update(ros::Time(1.0), jobs));
+        ASSERT_TRUE(free.next(pose(0.2, 0.0, 1.3), next));
+        EXPECT_EQ(next.model_id, "near");
+}
+
+TEST(PickQueue, StaleDetections){
+        iwtros::PickQueue queue;
+        std::vector<iwtros::PickJob> jobs(1, job("box", 0.5, 0.0, 1.2));
+        ASSERT_TRUE(queue.update(ros::Time(2.0), jobs));
+        EXPECT_TRUE(queue.validated());
+        // Older than the current detection
+        EXPECT_FALSE(queue.update(ros::Time(1.0), jobs));
+
+        queue.picked(ros::Time(5.0));
+        EXPECT_FALSE(queue.validated());
+        // Taken before the pick ended, still shows the picked box
+        EXPECT_FALSE(queue.update(ros::Time(4.0), jobs));
+        EXPECT_FALSE(queue.update(ros::Time(5.0), jobs));
+        EXPECT_FALSE(queue.validated());
+        EXPECT_TRUE(queue.update(ros::Time(6.0), jobs));
+        EXPECT_TRUE(queue.validated());
+        EXPECT_EQ(queue.stamp(), ros::Time(6.0));
+}
+
+TEST(PickQueue, Empty){
+        iwtros::PickQueue queue;
+        iwtros::PickJob next;
+        EXPECT_TRUE(queue.empty());
+        EXPECT_FALSE(queue.next(pose(0.0, 0.0, 0.0), next));
+        ASSERT_TRUE(queue.update(ros::Time(1.0), std::vector<iwtros::PickJob>(1, job("box", 0.5, 0.0, 1.2))));
+        queue.clear();
+        EXPECT_TRUE(queue.empty());
+}
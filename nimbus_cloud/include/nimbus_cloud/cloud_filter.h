@@ -6,7 +6,7 @@
 #include <pcl_conversions/pcl_conversions.h>
 #include <pcl/point_cloud.h>
 
-#include <pcl/filters/voxel_grid.h>
+#include <nimbus_common/voxel_grid.hpp>
 
 
 namespace nimbus
@@ -23,16 +23,21 @@ namespace nimbus
             typedef pcl::PointCloud<PointInType> PointCloudType;
             typedef typename PointCloudType::Ptr PoinCloudtPtr;
             typedef typename PointCloudType::ConstPtr PointConstPtr;
+            nimbus::VoxelGrid<PointInType> _voxel;
         public:
             cloudFilter(ros::NodeHandle nh);
             ~cloudFilter();
 
             /**
-             * @brief Pass through Filter
+             * @brief Voxel grid Filter
              * @param blob input point clouds
-             * @param res Filteres Point cloud.
+             * @param res Filteres Point cloud, the finite input points if it fails
+             * @param leaf Voxel edge length in meter
+             * @param mode Voxel centroid or first point of the voxel
+             * @return false if the leaf is not positive or too small for the extent of the cloud
              */
-            void voxelGrid(const PointCloudType blob, PointCloudType &res);
+            bool voxelGrid(const PointConstPtr &blob, PointCloudType &res, float leaf = 0.01f,
+                           nimbus::VoxelMode mode = nimbus::VoxelMode::CENTROID);
     };
 }
 
@@ -43,14 +48,10 @@ template <class PointInType>
 nimbus::cloudFilter<PointInType>::~cloudFilter(){}
 
 template <class PointInType>
-void nimbus::cloudFilter<PointInType>::voxelGrid(const PointCloudType blob, PointCloudType &res)
+bool nimbus::cloudFilter<PointInType>::voxelGrid(const PointConstPtr &blob, PointCloudType &res, float leaf,
+                                                 nimbus::VoxelMode mode)
 {
-    pcl::PointCloud<pcl::PointXYZI>::Ptr temp (new pcl::PointCloud<pcl::PointXYZI>());
-    pcl::copyPointCloud(blob, *temp);
-    pcl::VoxelGrid<pcl::PointXYZI> vox;
-    vox.setInputCloud(temp);
-    vox.setLeafSize(0.01f, 0.01f, 0.01f);
-    vox.filter(res);
+    return _voxel.filter(blob, leaf, mode, res);
 }
 
 #endif
\ No newline at end of file
@@ -8,12 +8,12 @@
 
 #include <pcl/search/search.h>
 #include <pcl/search/kdtree.h>
-#include <pcl/filters/uniform_sampling.h>
 
 #include <pcl/keypoints/iss_3d.h>
 #include <pcl/keypoints/impl/iss_3d.hpp>
 #include <pcl/keypoints/narf_keypoint.h>
 
+#include <nimbus_common/voxel_grid.hpp>
 #include <nimbus_cloud/cloud_util.h>
 
 /** 
@@ -33,6 +33,7 @@ namespace nimbus{
             typedef boost::shared_ptr<PointCloud> PointCloudPtr;
             typedef boost::shared_ptr<const PointCloud> PointCloudConstPtr;
             pcl::search::KdTree<pcl::PointXYZI>::Ptr tree;
+            nimbus::VoxelGrid<PointInType> _voxel;
         public:
             typename pcl::PointCloud<PointInType>::Ptr keypointOut;
             double keypoint_sr;
@@ -41,8 +42,10 @@ namespace nimbus{
             ~cloudKeypoints();
             //Functions
             /**
-             * @brief Uniform sampling Keypoints extraction (Detectors)
-             * http://docs.pointclouds.org/trunk/classpcl_1_1_uniform_sampling.html
+             * @brief Uniform sampling Keypoints extraction (Detectors), one point per voxel of size keypoint_sr
+             * Replaces pcl::UniformSampling, which keeps the point closest to the voxel center. The first
+             * (lowest index) point of the voxel is kept instead, the keypoints move by up to one voxel and
+             * depend on the point order. Without a valid keypoint_sr all finite points are keypoints.
              * @param blob Input cloud
              */
             void cloudUniformSampling(const PointCloudConstPtr blob);
@@ -72,13 +75,9 @@ nimbus::cloudKeypoints<PointInType>::~cloudKeypoints(){}
 
 template <class PointInType>
 void nimbus::cloudKeypoints<PointInType>::cloudUniformSampling(const PointCloudConstPtr blob){
-    pcl::UniformSampling<PointInType> uniSampling;
-    double searchRadius = this->computeCloudResolution(blob);
-    // this->keypoint_sr *= searchRadius;
-    uniSampling.setInputCloud(blob);
-    uniSampling.setRadiusSearch(keypoint_sr);
     keypointOut.reset(new pcl::PointCloud<PointInType>());
-    uniSampling.filter(*keypointOut);
+    // First point per voxel keeps the keypoints on the surface
+    _voxel.filter(blob, static_cast<float>(keypoint_sr), nimbus::VoxelMode::FIRST_POINT, *keypointOut);
 }
 
 template <class PointInType>
@@ -8,6 +8,9 @@
 #include <pcl/io/pcd_io.h>
 #include <boost/foreach.hpp>
 
+#include <box_detector/depth_frame.hpp>
+#include <box_detector/soa_frame.hpp>
+#include <box_detector/temporal_fusion.hpp>
 #include <nimbus_cloud/cloud_filter.h>
 
 template <class T>
@@ -16,6 +19,7 @@ class cloudMean : public nimbus::cloudFilter<T>
 private:
     typedef pcl::PointCloud<T> PointCloud;
     ros::NodeHandle _nh;
+    nimbus::RayTable::Ptr _rays;
 public:
     typedef nimbus::cloudFilter<T> cFilter; 
 public:
@@ -23,71 +27,72 @@ public:
     ~cloudMean();
 
     /**
-     * @brief This will take mean of individual points
+     * @brief Store a frame as compact depth frame (uint16 depth and amplitude)
+     * @param cloud Organized sensor cloud
+     */
+    void enqueue(const PointCloud &cloud);
+    /**
+     * @brief Same for a frame that is already planar (e.g. cropped)
+     * @param frame Organized planar frame
+     */
+    void enqueue(const nimbus::SoAFrame &frame);
+    /**
+     * @brief This will take mean of individual points, computed in depth space
      * @param res 
      * @param width 
      * @param height 
      * ToDo: Implementation of voxel grid filter
      */
     void meanFilter(pcl::PointCloud<T> &res, int width, int height);
+    /**
+     * @brief Amplitude weighted mean with per pixel outlier rejection, empties the queue
+     * @param res Fused cloud
+     * @param confidence Per pixel confidence in [0, 1]
+     */
+    void confidenceFilter(pcl::PointCloud<T> &res, std::vector<float> &confidence);
     // Variables
-    pcl::SynchronizedQueue<PointCloud> cloudQueue;
+    pcl::SynchronizedQueue<nimbus::DepthFrame> cloudQueue;
+    nimbus::ConfidenceFusion<T> fusion;
 
 };
 
 template <class T>
-cloudMean<T>::cloudMean(ros::NodeHandle nh): cFilter(nh), _nh(nh){}
+cloudMean<T>::cloudMean(ros::NodeHandle nh): cFilter(nh), _nh(nh), _rays(new nimbus::RayTable()){}
 template <class T>
 cloudMean<T>::~cloudMean(){}
 
+template <class T>
+void cloudMean<T>::enqueue(const PointCloud &cloud){
+    // Queued frames keep their table when the sensor layout changes
+    if(!_rays->matches(cloud.width, cloud.height)) _rays.reset(new nimbus::RayTable());
+    _rays->update(cloud);
+    nimbus::DepthFrame frame;
+    if(frame.fromCloud(cloud, _rays)) cloudQueue.enqueue(frame);
+}
+
+template <class T>
+void cloudMean<T>::enqueue(const nimbus::SoAFrame &frame){
+    if(!_rays->matches(frame.width(), frame.height())) _rays.reset(new nimbus::RayTable());
+    nimbus::DepthFrame depth;
+    if(frame.toDepthFrame(_rays, depth)) cloudQueue.enqueue(depth);
+}
+
 template <class T>
 void cloudMean<T>::meanFilter(pcl::PointCloud<T> &res, int width, int height){
-    if(cloudQueue.isEmpty()) return;
-    std::vector<float> conf(width*height, 0);
-    std::vector<float> mnCounter(width*height, 0);
-    std::vector<float> addX(width*height, 0);
-    std::vector<float> addY(width*height, 0);
-    std::vector<float> addZ(width*height, 0);
-    std::vector<float> ampt(width*height, 0);
-    //Point_Cloud sum;
-    PointCloud tempToFilter;
-    PointCloud tempC;
-    res.width = width;
-    res.height = height;
+    nimbus::DepthFrame mean;
+    if(!nimbus::meanDepth(cloudQueue, mean)) return;
+    // XYZ is only reconstructed once for the mean
+    mean.toCloud(res);
+}
+
+template <class T>
+void cloudMean<T>::confidenceFilter(pcl::PointCloud<T> &res, std::vector<float> &confidence){
+    std::vector<nimbus::DepthFrame> frames;
     while (!cloudQueue.isEmpty()){
-        cloudQueue.dequeue(tempC);
-        //Filter Implementation
-        //this->voxelGrid(tempToFilter, tempC);
-        int i = 0;
-        for(int i = 0; i < tempC.points.size(); i++){
-            if(!std::isnan(tempC.points[i].x)){
-                addX[i] += tempC.points[i].x;
-                addY[i] += tempC.points[i].y;
-                addZ[i] += tempC.points[i].z;
-                ampt[i] += tempC.points[i].intensity;
-                mnCounter[i] +=1;
-                // ROS_INFO("X: %f, Y: %f, Z:%f AMP: %f, Mean Counter: %d", addX[i], addY[i], addZ[i], ampt[i], mnCounter[i]);
-            }else{
-                conf[i] = 1;
-                mnCounter[i] = 0;
-            }
-        }
-    }
-    for(int i = 0; i < mnCounter.size(); i++){
-        pcl::PointXYZI temPoint;
-        if(mnCounter[i] == 0){
-            temPoint.x = NAN;
-            temPoint.y = NAN;
-            temPoint.z = NAN;
-            temPoint.intensity = NAN;
-        }else{
-            temPoint.x = addX[i] / mnCounter[i];
-            temPoint.y = addY[i] / mnCounter[i];
-            temPoint.z = addZ[i] / mnCounter[i];
-            temPoint.intensity = ampt[i] / mnCounter[i];
-        }
-        res.points.push_back(temPoint);
+        frames.push_back(nimbus::DepthFrame());
+        cloudQueue.dequeue(frames.back());
     }
+    fusion.fuse(frames, res, confidence);
 }
 
 #endif
\ No newline at end of file
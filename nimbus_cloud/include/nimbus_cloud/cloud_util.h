@@ -11,6 +11,8 @@
 
 #include <pcl/range_image/range_image.h>
 
+#include <nimbus_common/parallel.hpp>
+
 namespace nimbus{
     template <class T>
     class cloudEdit
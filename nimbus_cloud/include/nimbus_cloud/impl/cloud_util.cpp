@@ -52,16 +52,26 @@ void nimbus::cloudEdit<T>::zRemover(const PointCloudConstPtr blob,
                     PointCloud &res){
     if(blob->points.empty())
         return;
-    pcl::PointXYZI tempPoints;
-    for(int i = 0; i < blob->points.size(); i++){
-        if(maxDis > blob->points[i].z > minDis){
-            tempPoints.x = blob->points[i].x;
-            tempPoints.y = blob->points[i].y;
-            tempPoints.z = blob->points[i].z;
-            tempPoints.intensity = blob->points[i].intensity;
-            res.points.push_back(tempPoints);
-        } 
-    }
+    // Per band point lists, concatenated in band order to keep the point order
+    const std::size_t width = std::max<std::size_t>(blob->width, 1);
+    const std::size_t rows = (blob->points.size() + width - 1) / width;
+    const nimbus::RowBands config;
+    std::vector<std::vector<T, Eigen::aligned_allocator<T> > > bands(config.bands(rows, width));
+    nimbus::parallelRows(rows, width, config, [&](std::size_t begin, std::size_t end, unsigned int band){
+        end = std::min(end * width, blob->points.size());
+        for(std::size_t i = begin * width; i < end; i++){
+            if(blob->points[i].z < maxDis && blob->points[i].z > minDis){
+                T tempPoints;
+                tempPoints.x = blob->points[i].x;
+                tempPoints.y = blob->points[i].y;
+                tempPoints.z = blob->points[i].z;
+                tempPoints.intensity = blob->points[i].intensity;
+                bands[band].push_back(tempPoints);
+            } 
+        }
+    });
+    for(const auto &band: bands)
+        res.points.insert(res.points.end(), band.begin(), band.end());
     res.width = res.points.size();
     res.height = 1;
 }
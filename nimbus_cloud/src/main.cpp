@@ -130,7 +130,7 @@ int main(int argc, char** argv){
     {
         cRecog.updateParm(_ns, _ks, _ds, rf_rad_, cg_size_, cg_thresh_);
         if(cMean.cloudQueue.size() < 10){
-            cMean.cloudQueue.enqueue(blob);
+            cMean.enqueue(blob);
             newCloud = false;
         }else{
             cRecog.modelConstruct(model);
@@ -12,13 +12,17 @@
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 #include <geometry_msgs/TransformStamped.h>
 #include <std_msgs/Bool.h>
+#include <sensor_msgs/Image.h>
 
+#include <nimbus_common/confidence_image.hpp>
 #include <nimbus_cloud/cloud_mean.h>
 #include <nimbus_cloud/cloud_util.h>
 #include <nimbus_cloud/cloudEditConfig.h>
 #include <dynamic_reconfigure/server.h>
 
 double remove_w, remove_h, z_max, z_min;
+bool confidence_fusion = false;
+int fusion_frames = 5;
 bool save = false;
 
 typedef pcl::PointCloud<pcl::PointXYZI> PointCloud;
@@ -40,6 +44,8 @@ void dynamicCallback(nimbus_cloud::cloudEditConfig &config, uint32_t data)
     remove_h = config.per_height;
     z_max = config.z_max;
     z_min = config.z_min;
+    confidence_fusion = config.confidence_fusion;
+    fusion_frames = config.fusion_frames;
 }
 
 int main(int argc, char** argv){
@@ -48,6 +54,8 @@ int main(int argc, char** argv){
     ros::Subscriber sub = nh.subscribe<PointCloud>("/nimbus/pointcloud", 10, callback);
     ros::Subscriber subSave = nh.subscribe<std_msgs::Bool>("save_pointcloud", 10, saveCallback);
     ros::Publisher pub = nh.advertise<PointCloud>("pointcloud", 5);
+    // Per pixel confidence of the fused frame before the crop, 32FC1
+    ros::Publisher pubConfidence = nh.advertise<sensor_msgs::Image>("confidence", 5);
     static tf2_ros::StaticTransformBroadcaster staticTrans;
 
     cloudMean<pcl::PointXYZI> cE(nh);
@@ -74,20 +82,27 @@ int main(int argc, char** argv){
     while (ros::ok())
     {
         if(newCloud){
-            if(cE.cloudQueue.size() < 20){
-                cE.cloudQueue.enqueue(cloud_blob);
+            int window = confidence_fusion ? fusion_frames : 20;
+            if(cE.cloudQueue.size() < window){
+                cE.enqueue(cloud_blob);
                 newCloud = false;
             }
             else{
                 PointCloud::Ptr cloud(new PointCloud());
-                PointCloud::Ptr cloudE(new PointCloud());
                 PointCloud::Ptr cloudZ(new PointCloud());
-                cE.meanFilter (*cloud, cloud_blob.width, cloud_blob.height);
-                cloud_edit.remover(cloud, cloud_blob.width, cloud_blob.height, remove_w, remove_h, *cloudE);
-                float addZ = 0;
-                float counter = 0;
-                
-                cloud_edit.zRemover(cloudE, z_max, z_min, *cloudZ);
+                std::vector<float> confidence;
+                if(confidence_fusion){
+                    cE.confidenceFilter(*cloud, confidence);
+                    sensor_msgs::Image map;
+                    if(nimbus::confidenceImage(*cloud, confidence, "Mcamera", map)) pubConfidence.publish(map);
+                }
+                else cE.meanFilter (*cloud, cloud_blob.width, cloud_blob.height);
+                // Crop and z limits on the planar frame, only the remaining points are published
+                nimbus::SoAFrame frame, cropped;
+                frame.fromCloud(*cloud);
+                frame.crop(remove_w, remove_h, cropped);
+                cropped.limitZ(z_min, z_max);
+                cropped.toCloud(*cloudZ, false);
                 if(save == true){
                     ROS_INFO("Saving");
                     pcl::io::savePCDFile("model1.pcd", *cloudZ);
@@ -0,0 +1,64 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file confidence_image.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/image_encodings.h>
+
+namespace nimbus
+{
+    /**
+     * @brief Per pixel confidence of a fused frame as 32FC1 image in the layout of the cloud
+     * @param cloud Fused cloud, the image gets its sensor stamp
+     * @param confidence One value per point of the cloud
+     * @param frame Frame id of the image
+     * @param map Result
+     * @return false if the confidence does not match the cloud
+     */
+    template <class PointType>
+    bool confidenceImage(const pcl::PointCloud<PointType> &cloud, const std::vector<float> &confidence,
+                         const std::string &frame, sensor_msgs::Image &map)
+    {
+        if(confidence.size() != cloud.points.size()) return false;
+        map.header.frame_id = frame;
+        pcl_conversions::fromPCL(cloud.header.stamp, map.header.stamp);
+        map.width = cloud.width;
+        map.height = cloud.height;
+        map.encoding = sensor_msgs::image_encodings::TYPE_32FC1;
+        map.is_bigendian = false;
+        map.step = map.width * sizeof(float);
+        map.data.resize(confidence.size() * sizeof(float));
+        std::memcpy(map.data.data(), confidence.data(), map.data.size());
+        return true;
+    }
+}
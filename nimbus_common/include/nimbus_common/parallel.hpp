@@ -0,0 +1,137 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file parallel.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace nimbus
+{
+    /**
+     * @brief Number of worker threads to use
+     * @param threads Requested number, 0 selects the hardware concurrency
+     */
+    inline unsigned hardwareThreads(unsigned threads)
+    {
+        if(threads != 0) return threads;
+        unsigned hw = std::thread::hardware_concurrency();
+        return hw == 0 ? 1 : hw;
+    }
+
+    /**
+     * @brief Splits [0, size) into contiguous chunks and runs fn(begin, end, chunk) on each.
+     * The calling thread processes chunk 0, the remaining chunks run on their own threads.
+     * Chunk boundaries only depend on size and chunks, so per-chunk partial results merged
+     * in chunk order are reproducible.
+     * @param size Number of elements
+     * @param chunks Number of chunks, clamped to size
+     * @param fn Callable as fn(std::size_t begin, std::size_t end, unsigned chunk)
+     */
+    template <class Function>
+    void parallelFor(std::size_t size, unsigned chunks, Function fn)
+    {
+        if(size == 0) return;
+        chunks = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(chunks, size)));
+        if(chunks == 1)
+        {
+            fn(std::size_t(0), size, 0u);
+            return;
+        }
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        for(unsigned c = 1; c < chunks; ++c)
+            workers.emplace_back(fn, (size * c) / chunks, (size * (c + 1)) / chunks, c);
+        fn(std::size_t(0), size / chunks, 0u);
+        for(auto &worker: workers) worker.join();
+    }
+
+    /**
+     * @brief Row band split of an organized frame for the per pixel stages.
+     * By default there is one band per thread, so floating point reductions depend on the
+     * thread count. Deterministic mode uses a fixed number of bands (independent of the
+     * machine) and merges the partial results in band order.
+     */
+    struct RowBands
+    {
+        static const unsigned int DETERMINISTIC_BANDS = 16;
+        static const std::size_t MIN_BAND_PIXELS = 8192;    // Below that a thread costs more than it saves
+        unsigned int threads;       // 0 selects the hardware concurrency
+        bool deterministic;
+
+        RowBands(unsigned int threads = 0, bool deterministic = false):
+            threads(threads), deterministic(deterministic){}
+
+        /** Number of bands for a frame, only depends on the frame size in deterministic mode */
+        unsigned int bands(std::size_t rows, std::size_t width) const
+        {
+            const std::size_t bySize = std::max<std::size_t>(1, (rows * width) / MIN_BAND_PIXELS);
+            const std::size_t wanted = deterministic ? DETERMINISTIC_BANDS : hardwareThreads(threads);
+            return static_cast<unsigned int>(std::max<std::size_t>(1, std::min(std::min(wanted, bySize), rows)));
+        }
+    };
+
+    /**
+     * @brief Runs fn(rowBegin, rowEnd, band) over the row bands of a frame. Consecutive
+     * bands are grouped onto at most the configured number of threads.
+     * @param rows Frame height (or any row count, e.g. mask words)
+     * @param width Pixels per row, only used for the band size
+     * @param config Thread count and determinism
+     * @param fn Callable as fn(std::size_t begin, std::size_t end, unsigned band)
+     * @return Number of bands, size of the partial result array for parallelReduceRows
+     */
+    template <class Function>
+    unsigned int parallelRows(std::size_t rows, std::size_t width, const RowBands &config, Function fn)
+    {
+        if(rows == 0) return 0;
+        const unsigned int bands = config.bands(rows, width);
+        const unsigned int threads = std::min(bands, hardwareThreads(config.threads));
+        parallelFor(bands, threads, [&](std::size_t begin, std::size_t end, unsigned int){
+            for(std::size_t b = begin; b < end; ++b)
+                fn((rows * b) / bands, (rows * (b + 1)) / bands, static_cast<unsigned int>(b));
+        });
+        return bands;
+    }
+
+    /**
+     * @brief Row band reduction: fn(begin, end, partial) fills one partial per band starting
+     * from init, merge(total, partial) combines them in band order.
+     */
+    template <class Partial, class Function, class Merge>
+    Partial parallelReduceRows(std::size_t rows, std::size_t width, const RowBands &config,
+                               const Partial &init, Function fn, Merge merge)
+    {
+        std::vector<Partial> partials(config.bands(std::max<std::size_t>(rows, 1), width), init);
+        parallelRows(rows, width, config, [&](std::size_t begin, std::size_t end, unsigned int band){
+            fn(begin, end, partials[band]);
+        });
+        Partial total = init;
+        for(const auto &partial: partials) merge(total, partial);
+        return total;
+    }
+}
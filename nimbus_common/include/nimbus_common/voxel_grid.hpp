@@ -0,0 +1,329 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2020 IWT Wirtschaft und Technik GmbH
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ * @file voxel_grid.hpp
+ * @author Vishnuprasad Prachandabhanu (vishnu.pbhat93@gmail.com)
+ */
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/common/common.h>
+
+#include <nimbus_common/parallel.hpp>
+
+namespace nimbus
+{
+    /**
+     * @brief Point indices grouped by voxel (compressed row layout).
+     * Voxel v owns indices[offsets[v]] ... indices[offsets[v + 1] - 1], in ascending order.
+     */
+    struct VoxelIndices
+    {
+        std::vector<int> indices;
+        std::vector<int> offsets;
+        std::size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    };
+
+    /** Representative point of a voxel */
+    enum class VoxelMode: unsigned char{
+        CENTROID = 0,       // Mean x, y, z, other fields from the first point
+        FIRST_POINT = 1     // Lowest index point, keeps a real surface sample
+    };
+
+    /**
+     * @brief Voxel grid downsampler. Points are hashed by voxel key and partitioned into a
+     * fixed number of buckets in parallel; every bucket is then sorted on its own.
+     * The voxel order only depends on the input, not on the number of threads.
+     * Non finite points are skipped.
+     * @tparam PointType 
+     */
+    template <class PointType>
+    class VoxelGrid
+    {
+        private:
+            unsigned int _threads;
+            static const unsigned int BUCKET_BITS = 8;
+            static const unsigned int AXIS_BITS = 21;
+            // Reused between calls
+            std::vector<std::uint64_t> _keys;
+            std::vector<std::pair<std::uint64_t, int> > _pairs;
+        public:
+            /**
+             * @param threads Worker threads, 0 selects the hardware concurrency 
+             */
+            VoxelGrid(unsigned int threads = 0);
+            ~VoxelGrid();
+            void setThreads(unsigned int threads){ _threads = threads; }
+            /**
+             * @brief Groups the point indices of the cloud by voxel
+             * @param blob Input cloud, organized or not
+             * @param leaf Voxel edge length in meter
+             * @param voxels Result
+             * @return false if the leaf is not positive or the grid does not fit in 63 bit keys
+             */
+            bool voxelize(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, float leaf, 
+                          VoxelIndices &voxels);
+            /**
+             * @brief One point per voxel from already grouped indices
+             * @param blob Cloud the voxels were computed from
+             * @param voxels Output of voxelize
+             * @param mode Representative point
+             * @param res Unorganized result, one point per voxel
+             */
+            void reduce(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, const VoxelIndices &voxels,
+                        VoxelMode mode, pcl::PointCloud<PointType> &res);
+            /**
+             * @brief Downsamples the cloud. If it can not be voxelized, res holds the finite input
+             * points without downsampling, dense and unorganized like a reduced cloud
+             * @param blob Input cloud
+             * @param leaf Voxel edge length in meter
+             * @param mode Representative point
+             * @param res Downsampled cloud
+             * @return false if the cloud could not be voxelized
+             */
+            bool filter(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, float leaf, 
+                        VoxelMode mode, pcl::PointCloud<PointType> &res);
+    };
+}
+
+template <class PointType>
+nimbus::VoxelGrid<PointType>::VoxelGrid(unsigned int threads): _threads(threads){}
+template <class PointType>
+nimbus::VoxelGrid<PointType>::~VoxelGrid(){}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+bool 
+nimbus::VoxelGrid<PointType>::voxelize(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, float leaf, 
+                                       VoxelIndices &voxels)
+{
+    voxels.indices.clear();
+    voxels.offsets.clear();
+    const auto &points = blob->points;
+    const std::size_t size = points.size();
+    if(!(leaf > 0) || size == 0) return false;
+
+    // Small clouds are not worth a thread
+    const unsigned int chunks = static_cast<unsigned int>(
+        std::max<std::size_t>(1, std::min<std::size_t>(hardwareThreads(_threads), size / 4096)));
+    const unsigned int buckets = 1u << BUCKET_BITS;
+
+    // Bounding box of the finite points
+    std::vector<Eigen::Array3f, Eigen::aligned_allocator<Eigen::Array3f> > minPart(chunks), maxPart(chunks);
+    parallelFor(size, chunks, [&](std::size_t begin, std::size_t end, unsigned int chunk){
+        Eigen::Array3f minP = Eigen::Array3f::Constant(std::numeric_limits<float>::max());
+        Eigen::Array3f maxP = Eigen::Array3f::Constant(std::numeric_limits<float>::lowest());
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            if(!pcl::isFinite(points[i])) continue;
+            Eigen::Array3f p(points[i].x, points[i].y, points[i].z);
+            minP = minP.min(p);
+            maxP = maxP.max(p);
+        }
+        minPart[chunk] = minP;
+        maxPart[chunk] = maxP;
+    });
+    Eigen::Array3f minP = minPart[0], maxP = maxPart[0];
+    for(unsigned int c = 1; c < chunks; ++c)
+    {
+        minP = minP.min(minPart[c]);
+        maxP = maxP.max(maxPart[c]);
+    }
+    if((minP > maxP).any())
+    {
+        // No finite point, zero voxels
+        voxels.offsets.assign(1, 0);
+        return true;
+    }
+    const float inverse = 1.0f / leaf;
+    const Eigen::Array3f extent = ((maxP - minP) * inverse).floor() + 1.0f;
+    if((extent >= static_cast<float>(1u << AXIS_BITS)).any()) return false;
+
+    // Voxel keys and per chunk bucket histograms
+    const std::uint64_t invalid = std::numeric_limits<std::uint64_t>::max();
+    _keys.resize(size);
+    std::vector<std::size_t> histogram(static_cast<std::size_t>(chunks) * buckets, 0);
+    auto bucketOf = [](std::uint64_t key){
+        // Fibonacci hashing spreads neighbouring voxels over all buckets
+        return static_cast<unsigned int>((key * 0x9E3779B97F4A7C15ull) >> (64 - BUCKET_BITS));
+    };
+    parallelFor(size, chunks, [&](std::size_t begin, std::size_t end, unsigned int chunk){
+        std::size_t *hist = &histogram[static_cast<std::size_t>(chunk) * buckets];
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            if(!pcl::isFinite(points[i]))
+            {
+                _keys[i] = invalid;
+                continue;
+            }
+            const std::uint64_t ix = static_cast<std::uint64_t>((points[i].x - minP[0]) * inverse);
+            const std::uint64_t iy = static_cast<std::uint64_t>((points[i].y - minP[1]) * inverse);
+            const std::uint64_t iz = static_cast<std::uint64_t>((points[i].z - minP[2]) * inverse);
+            const std::uint64_t key = ix | (iy << AXIS_BITS) | (iz << (2 * AXIS_BITS));
+            _keys[i] = key;
+            ++hist[bucketOf(key)];
+        }
+    });
+
+    // Bucket major offsets, chunks keep their order inside a bucket
+    std::vector<std::size_t> bucketStart(buckets + 1, 0);
+    std::size_t total = 0;
+    for(unsigned int b = 0; b < buckets; ++b)
+    {
+        bucketStart[b] = total;
+        for(unsigned int c = 0; c < chunks; ++c)
+        {
+            std::size_t &h = histogram[static_cast<std::size_t>(c) * buckets + b];
+            const std::size_t count = h;
+            h = total;
+            total += count;
+        }
+    }
+    bucketStart[buckets] = total;
+
+    // Scatter
+    _pairs.resize(total);
+    parallelFor(size, chunks, [&](std::size_t begin, std::size_t end, unsigned int chunk){
+        std::size_t *cursor = &histogram[static_cast<std::size_t>(chunk) * buckets];
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            if(_keys[i] == invalid) continue;
+            _pairs[cursor[bucketOf(_keys[i])]++] = std::make_pair(_keys[i], static_cast<int>(i));
+        }
+    });
+
+    // Sort every bucket and count its voxels
+    std::vector<int> voxelCount(buckets, 0);
+    parallelFor(buckets, chunks, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t b = begin; b < end; ++b)
+        {
+            auto first = _pairs.begin() + bucketStart[b];
+            auto last = _pairs.begin() + bucketStart[b + 1];
+            // Pairs compare by key then index, points in a voxel stay in index order
+            std::sort(first, last);
+            int count = 0;
+            for(auto it = first; it != last; ++it)
+                if(it == first || it->first != (it - 1)->first) ++count;
+            voxelCount[b] = count;
+        }
+    });
+    std::vector<int> voxelStart(buckets, 0);
+    int voxelTotal = 0;
+    for(unsigned int b = 0; b < buckets; ++b)
+    {
+        voxelStart[b] = voxelTotal;
+        voxelTotal += voxelCount[b];
+    }
+
+    voxels.indices.resize(total);
+    voxels.offsets.resize(voxelTotal + 1);
+    parallelFor(buckets, chunks, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t b = begin; b < end; ++b)
+        {
+            int v = voxelStart[b];
+            for(std::size_t k = bucketStart[b]; k < bucketStart[b + 1]; ++k)
+            {
+                if(k == bucketStart[b] || _pairs[k].first != _pairs[k - 1].first)
+                    voxels.offsets[v++] = static_cast<int>(k);
+                voxels.indices[k] = _pairs[k].second;
+            }
+        }
+    });
+    voxels.offsets[voxelTotal] = static_cast<int>(total);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+void 
+nimbus::VoxelGrid<PointType>::reduce(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, 
+                                     const VoxelIndices &voxels, VoxelMode mode, pcl::PointCloud<PointType> &res)
+{
+    const std::size_t size = voxels.size();
+    res.points.resize(size);
+    res.header = blob->header;
+    res.width = static_cast<std::uint32_t>(size);
+    res.height = 1;
+    res.is_dense = true;
+    const unsigned int chunks = static_cast<unsigned int>(
+        std::max<std::size_t>(1, std::min<std::size_t>(hardwareThreads(_threads), size / 1024)));
+    parallelFor(size, chunks, [&](std::size_t begin, std::size_t end, unsigned int){
+        for(std::size_t v = begin; v < end; ++v)
+        {
+            const int first = voxels.offsets[v];
+            const int last = voxels.offsets[v + 1];
+            PointType point = blob->points[voxels.indices[first]];
+            if(mode == VoxelMode::CENTROID && last - first > 1)
+            {
+                double x = 0, y = 0, z = 0;
+                for(int k = first; k < last; ++k)
+                {
+                    const PointType &p = blob->points[voxels.indices[k]];
+                    x += p.x;
+                    y += p.y;
+                    z += p.z;
+                }
+                const double n = last - first;
+                point.x = static_cast<float>(x / n);
+                point.y = static_cast<float>(y / n);
+                point.z = static_cast<float>(z / n);
+            }
+            res.points[v] = point;
+        }
+    });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <class PointType>
+bool 
+nimbus::VoxelGrid<PointType>::filter(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, float leaf, 
+                                     VoxelMode mode, pcl::PointCloud<PointType> &res)
+{
+    VoxelIndices voxels;
+    pcl::PointCloud<PointType> out;
+    if(!voxelize(blob, leaf, voxels))
+    {
+        // Following stages (normals, MLS) expect the NaN free output of a reduce
+        out.header = blob->header;
+        out.points.reserve(blob->points.size());
+        for(const PointType &p: blob->points)
+            if(pcl::isFinite(p)) out.points.push_back(p);
+        out.width = static_cast<std::uint32_t>(out.points.size());
+        out.height = 1;
+        out.is_dense = true;
+        res.swap(out);
+        return false;
+    }
+    reduce(blob, voxels, mode, out);
+    res.swap(out);
+    return true;
+}
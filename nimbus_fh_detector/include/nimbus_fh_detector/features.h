@@ -8,7 +8,6 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
-#include <pcl/filters/uniform_sampling.h>
 #include <pcl/features/normal_3d.h>
 #include <pcl/features/normal_3d_omp.h>
 #include <pcl/kdtree/impl/kdtree_flann.hpp>
@@ -45,6 +44,7 @@ namespace nimbus{
             double _keypoint_sr;
             double _norm_sr;
             double _desc_sr;
+            nimbus::VoxelGrid<PointType> _voxel;
         
         public:
             Features(ros::NodeHandle nh, double normal_sr, double descriptor_sr, double keypoint_sr);
@@ -55,6 +55,15 @@ namespace nimbus{
             typename pcl::PointCloud<DescriptorType>::Ptr descriptor;
             typename pcl::PointCloud<pcl::ReferenceFrame>::Ptr board;
             //Functions
+            /**
+             * @brief Uniform keypoints, the first point of every voxel of size keypoint_sr
+             * Replaces pcl::UniformSampling, which keeps the point closest to the voxel center. The
+             * lowest index point is a real surface sample as well, but it can be up to one voxel away,
+             * so descriptors of models trained with pcl::UniformSampling should be retrained.
+             * Without a valid keypoint_sr all finite points are keypoints.
+             * @param blob Input cloud
+             * @param res Keypoints
+             */
             void keypointUniformSampling(const PointCloudTypeConstPtr blob, pcl::PointCloud<PointType> &res);
             /**
              * @brief Normal Estimation with Kd Tree Search method
@@ -87,12 +96,8 @@ nimbus::Features<PointType, NormalType, DescriptorType>::~Features(){}
 template <class PointType, class NormalType, class DescriptorType>
 void nimbus::Features<PointType, NormalType, DescriptorType>::keypointUniformSampling(const PointCloudTypeConstPtr blob, pcl::PointCloud<PointType> &res)
 {
-    pcl::UniformSampling<PointType> uniform;
-    uniform.setInputCloud(blob);
-    uniform.setRadiusSearch(_keypoint_sr);
-    typename pcl::PointCloud<PointType>::Ptr keypoint (new pcl::PointCloud<PointType>());
-    uniform.filter(*keypoint);
-    pcl::copyPointCloud(*keypoint, res);
+    // Keypoints have to stay on the surface for the descriptors, no centroid
+    _voxel.filter(blob, static_cast<float>(_keypoint_sr), nimbus::VoxelMode::FIRST_POINT, res);
 }
 
 template <class PointType, class NormalType, class DescriptorType>
@@ -11,10 +11,12 @@
 #include <pcl/kdtree/impl/kdtree_flann.hpp>
 #include <pcl/kdtree/kdtree_flann.h>
 
-#include <pcl/filters/voxel_grid.h>
 #include <pcl/surface/mls.h>
 #include <pcl/surface/poisson.h>
 
+#include <nimbus_common/voxel_grid.hpp>
+#include <box_detector/depth_filter.hpp>
+
 
 /** 
  * http://www.pointclouds.org/documentation/tutorials/#features-tutorial
@@ -28,27 +30,54 @@ namespace nimbus{
      */
     template <class PointType>
     class Filters{
+        private:
+            nimbus::VoxelGrid<PointType> _voxel;
+            nimbus::DepthBilateral<PointType> _bilateral;
         public:
             Filters();
             ~Filters();
             //Functions
             /**
-             * @brief Voxel grid filter
+             * @brief Voxel grid filter, NaN points are dropped
              * @param blob Input cloud
-             * @result is stored in: this->_filCloud
-             * @todo change the fixed parameter to dymanic so that it can be change during the run time.
+             * @param res Downsampled cloud, the finite input points if it fails
+             * @param leaf Voxel edge length in meter
+             * @param mode Voxel centroid or first point of the voxel
+             * @return false if the leaf is not positive or too small for the extent of the cloud
+             */
+            bool voxelGrid(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res,
+                           float leaf = 0.01f, nimbus::VoxelMode mode = nimbus::VoxelMode::CENTROID);
+            /**
+             * @brief Point indices of each voxel instead of a copied cloud
+             * @param blob Input cloud
+             * @param leaf Voxel edge length in meter
+             * @param voxels Result
              */
-            void voxelGrid(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res);
+            bool voxelIndices(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, float leaf, 
+                              nimbus::VoxelIndices &voxels);
             //Functions
             /**
              * @brief Moving Least Square filter with Upsampling
              * This method is falls under surface class of pcl
              * @param blob Input cloud
-             * @result is stored in: this->_filCloud
+             * @param res Smoothed cloud
+             * @param leaf Voxel size of the downsampling in front of the MLS
              * @todo change the fixed parameter to dymanic so that it can be change during the run time.
              * Current system do not initialized with PointXYZI
              */
-            void movingLeastSquare(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res);
+            void movingLeastSquare(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res,
+                                   float leaf = 0.01f);
+            /**
+             * @brief Edge preserving smoothing on the organized depth image, fast enough for every frame
+             * Separable bilateral filter on z, x and y follow the pixel ray. Replaces the mean over many frames.
+             * @param blob Organized input cloud
+             * @param res Smoothed cloud, same layout as the input
+             * @param radius Half kernel size in pixel
+             * @param sigma_space Spatial sigma in pixel
+             * @param sigma_depth Range sigma in meter
+             */
+            void bilateralDepth(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res,
+                                int radius = 2, float sigma_space = 1.5f, float sigma_depth = 0.01f);
             
     };
 }
@@ -58,26 +87,28 @@ template <class PointType>
 nimbus::Filters<PointType>::~Filters(){}
 
 template <class PointType>
-void nimbus::Filters<PointType>::voxelGrid(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res)
+bool nimbus::Filters<PointType>::voxelGrid(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res,
+                                           float leaf, nimbus::VoxelMode mode)
 {
-    pcl::VoxelGrid<PointType> vox;
-    vox.setInputCloud(blob);
-    // Leaf Size is 3cm
-    vox.setLeafSize(0.01f, 0.01f, 0.01f);
-    typename pcl::PointCloud<PointType>::Ptr filCloud (new pcl::PointCloud<PointType>());
-    vox.filter(*filCloud);
-    pcl::copyPointCloud(*filCloud, res);
+    return _voxel.filter(blob, leaf, mode, res);
 }
 
 template <class PointType>
-void nimbus::Filters<PointType>::movingLeastSquare(const boost::shared_ptr<const pcl::PointCloud<PointType>>  &blob, pcl::PointCloud<PointType> &res)
+bool nimbus::Filters<PointType>::voxelIndices(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, float leaf, 
+                                              nimbus::VoxelIndices &voxels)
+{
+    return _voxel.voxelize(blob, leaf, voxels);
+}
+
+template <class PointType>
+void nimbus::Filters<PointType>::movingLeastSquare(const boost::shared_ptr<const pcl::PointCloud<PointType>>  &blob, pcl::PointCloud<PointType> &res,
+                                                   float leaf)
 {
     typename pcl::search::KdTree<PointType>::Ptr tree (new pcl::search::KdTree<PointType>);
-    typename pcl::PointCloud<PointType>::Ptr tempCloud (new pcl::PointCloud<PointType>());
     typename pcl::PointCloud<PointType>::Ptr cloud (new pcl::PointCloud<PointType>());
-    std::vector<int> indices;
-    this->voxelGrid(blob, *tempCloud);
-    pcl::removeNaNFromPointCloud(*tempCloud, *cloud, indices);
+    // The voxel grid drops NaN points, also if it can not downsample
+    if(!this->voxelGrid(blob, *cloud, leaf))
+        ROS_WARN_THROTTLE(5, "Voxel grid of %f m failed, MLS on all %zu finite points", leaf, cloud->points.size());
     pcl::MovingLeastSquares<PointType, PointType> mls;
     mls.setInputCloud(cloud);
     mls.setSearchRadius(0.03);
@@ -91,4 +122,13 @@ void nimbus::Filters<PointType>::movingLeastSquare(const boost::shared_ptr<const
     pcl::copyPointCloud(*filCloud, res);
 }
 
+template <class PointType>
+void nimbus::Filters<PointType>::bilateralDepth(const boost::shared_ptr<const pcl::PointCloud<PointType>> &blob, pcl::PointCloud<PointType> &res,
+                                                int radius, float sigma_space, float sigma_depth)
+{
+    _bilateral.setParameter(radius, sigma_space, sigma_depth);
+    if(!_bilateral.filter(blob, res))
+        ROS_WARN_THROTTLE(5, "Bilateral depth filter needs an organized cloud");
+}
+
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 
 #include <nimbus_fh_detector/recognition.hpp>
 
+#include <algorithm>
+
 #include <pcl/io/pcd_io.h>
 #include <pcl/common/transforms.h>
 #include <pcl/recognition/cg/hough_3d.h>
@@ -12,6 +14,7 @@
 nimbus::Recognition::Recognition(ros::NodeHandle nh, const std::string path): _path(path), _features(nh, 0.01, 0.01, 0.01), _nh(nh)
 {
     pubPose = _nh.advertise<geometry_msgs::TransformStamped>("/iiwa/detected_pose", 5);
+    pubDetections = _nh.advertise<iwtros_msgs::objectDetections>("/nimbus_detector_node/detected_objects", 5);
     
 }
 nimbus::Recognition::~Recognition(){}
@@ -78,8 +81,11 @@ void nimbus::Recognition::correspondences(const pcl::PointCloud<pcl::PointXYZI>:
     }
 }
 
-void nimbus::Recognition::cloudHough3D(const pcl::PointCloud<pcl::PointXYZI>::ConstPtr blob)
+void nimbus::Recognition::cloudHough3D(const pcl::PointCloud<pcl::PointXYZI>::ConstPtr blob, const ros::Time &stamp)
 {
+    _detections.objects.clear();
+    _detections.header.frame_id = "camera";
+    _detections.header.stamp = stamp.isZero() ? ros::Time::now() : stamp;
     pcl::PointCloud<pcl::PointXYZI>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZI>());
     pcl::copyPointCloud(*blob, *cloud);
     this->correspondences(cloud);
@@ -108,6 +114,8 @@ void nimbus::Recognition::cloudHough3D(const pcl::PointCloud<pcl::PointXYZI>::Co
         if (rototranslations.size() > 0){
             std::cout << "The model is recognized for Correspondences size: " <<  model_scene_corr[i]->size () << " at: " << i << std::endl;
             std::vector<pcl::PointCloud<pcl::PointXYZI>::ConstPtr> instances;
+            _modelId = "box_" + std::to_string(i+1);
+            _scores.clear();
             for(std::size_t j = 0; j < rototranslations.size(); ++j)
             {
                 std::vector<int> indices;
@@ -119,10 +127,13 @@ void nimbus::Recognition::cloudHough3D(const pcl::PointCloud<pcl::PointXYZI>::Co
                 instances.push_back(rotated_model);
                 trasformations.push_back(rototranslations[j]);
                 clusters.push_back(clustered_corrs[j]);
+                // Share of the model keypoints that support the instance
+                _scores.push_back(std::min(1.0f, clustered_corrs[j].size() / static_cast<float>(_model_keypoints[i]->size())));
             }
             this->registrationICP(instances, cloud, rototranslations, clusters);
         }
     }
+    this->publishDetections();
 }
 
 void nimbus::Recognition::registrationICP (const std::vector<pcl::PointCloud<pcl::PointXYZI>::ConstPtr> instances,
@@ -194,7 +205,7 @@ void nimbus::Recognition::publishPose(std::vector<bool> mask, std::vector<Eigen:
     {
         if(mask[i])
         {
-            std::cout << "Instance " << i << " is GOOD! <---" << std::endl;
+            std::cout << "Instance " << i << " of " << _modelId << " is GOOD! <---" << std::endl;
             Eigen::Matrix3f rotation = rototranslations[i].block<3,3>(0,0);
             Eigen::Vector3f translation = rototranslations[i].block<3,1>(0, 3);
             tf2::Matrix3x3 mat(rotation (0,0), rotation (0,1), rotation (0,2),
@@ -206,16 +217,14 @@ void nimbus::Recognition::publishPose(std::vector<bool> mask, std::vector<Eigen:
             q.setRPY(roll, pitch, yaw);
             ROS_WARN("Position X: %f, Y: %f Z: %f", (float)translation(0), (float)translation(1), (float)translation(2));
             ROS_WARN("Rotation Roll: %f, Pitch: %f yaw: %f", (float)roll * (180 / M_PI), (float)pitch * (180 / M_PI), (float)yaw * (180 / M_PI));
-            pose.header.frame_id = "camera";
-            pose.child_frame_id = "object";
-            pose.header.stamp = ros::Time::now();
-            pose.transform.translation.x = translation(0);
-            pose.transform.translation.y = translation(1);
-            pose.transform.translation.z = translation(2);
-            pose.transform.rotation = tf2::toMsg(q);
-            pubPose.publish(pose);
-            tfb.sendTransform(pose);
-            ros::Duration(5.0).sleep();
+            iwtros_msgs::detectedObject object;
+            object.model_id = _modelId;
+            object.pose.position.x = translation(0);
+            object.pose.position.y = translation(1);
+            object.pose.position.z = translation(2);
+            object.pose.orientation = tf2::toMsg(q);
+            object.score = i < _scores.size() ? _scores[i] : 0;
+            _detections.objects.push_back(object);
         }
         else{
             // std::cout << "Instance " << i << " is bad!" << std::endl;
@@ -223,6 +232,27 @@ void nimbus::Recognition::publishPose(std::vector<bool> mask, std::vector<Eigen:
     }
 }
 
+void nimbus::Recognition::publishDetections()
+{
+    std::stable_sort(_detections.objects.begin(), _detections.objects.end(),
+                     [](const iwtros_msgs::detectedObject &a, const iwtros_msgs::detectedObject &b){ return a.score > b.score; });
+    _detections.latency = ros::Time::now() - _detections.header.stamp;
+    pubDetections.publish(_detections);
+    if(_detections.objects.empty()) return;
+    ROS_INFO("%zu verified instances, latency %f s", _detections.objects.size(), _detections.latency.toSec());
+    // Single pose consumers get the best instance
+    const iwtros_msgs::detectedObject &best = _detections.objects.front();
+    pose.header.frame_id = "camera";
+    pose.child_frame_id = "object";
+    pose.header.stamp = _detections.header.stamp;
+    pose.transform.translation.x = best.pose.position.x;
+    pose.transform.translation.y = best.pose.position.y;
+    pose.transform.translation.z = best.pose.position.z;
+    pose.transform.rotation = best.pose.orientation;
+    pubPose.publish(pose);
+    tfb.sendTransform(pose);
+}
+
 void nimbus::Recognition::visualization (const int num, 
                     const pcl::PointCloud<pcl::PointXYZI>::Ptr  scene,
                     std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > rototranslations,
@@ -8,6 +8,7 @@
 #include <tf2/LinearMath/Matrix3x3.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/TransformStamped.h>
+#include <iwtros_msgs/objectDetections.h>
 
 #include <pcl_ros/point_cloud.h>
 #include <pcl_conversions/pcl_conversions.h>
@@ -48,7 +49,12 @@ namespace nimbus{
             tf2_ros::TransformBroadcaster tfb;
             
             ros::Publisher pubPose;
+            ros::Publisher pubDetections;
             ros::Publisher _pub;
+            // Verified instances of all models in the current frame
+            iwtros_msgs::objectDetections _detections;
+            std::string _modelId;
+            std::vector<float> _scores;
 
         protected:
             std::vector<pcl::PointCloud<pcl::PointXYZI>::Ptr> _model;
@@ -64,7 +70,8 @@ namespace nimbus{
             ~Recognition();
             void constructModelParam();
             void correspondences(const pcl::PointCloud<pcl::PointXYZI>::ConstPtr blob);
-            void cloudHough3D(const pcl::PointCloud<pcl::PointXYZI>::ConstPtr blob);
+            /** Recognizes all models in blob and publishes the verified instances once, stamp: time of the source frame */
+            void cloudHough3D(const pcl::PointCloud<pcl::PointXYZI>::ConstPtr blob, const ros::Time &stamp = ros::Time());
             void registrationICP (const std::vector<pcl::PointCloud<pcl::PointXYZI>::ConstPtr> instances,
                                   const pcl::PointCloud<pcl::PointXYZI>::ConstPtr scene,
                                   std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > rototranslations, 
@@ -72,7 +79,10 @@ namespace nimbus{
             void hypothesisVerification(const pcl::PointCloud<pcl::PointXYZI>::ConstPtr blob,
                                         std::vector<pcl::PointCloud<pcl::PointXYZI>::ConstPtr> registered_instances,
                                         std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > rototranslations);
+            /** Adds the verified instances of the current model to the frame detections */
             void publishPose(std::vector<bool> mask, std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > rototranslations);
+            /** Publishes the frame detections, best first, the best one also as TF frame object */
+            void publishDetections();
             void visualization (const int num, 
                     const pcl::PointCloud<pcl::PointXYZI>::Ptr  scene,
                     std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > rototranslations,
@@ -8,21 +8,49 @@
 #include <pcl/io/pcd_io.h>
 #include <boost/foreach.hpp>
 
+#include <box_detector/depth_frame.hpp>
+#include <box_detector/soa_frame.hpp>
+#include <box_detector/table_plane.hpp>
+#include <box_detector/temporal_fusion.hpp>
+
 template <class PointType>
 class cloudUtilities 
 {
     public:
-        pcl::SynchronizedQueue<pcl::PointCloud<PointType>> _queue;
+        // Compact uint16 depth frames sharing one ray table
+        pcl::SynchronizedQueue<nimbus::DepthFrame> _queue;
+        nimbus::RayTable::Ptr _rays;
+        nimbus::ConfidenceFusion<PointType> _fusion;
+        nimbus::TablePlane _table;
     public:
         cloudUtilities();
         ~cloudUtilities();
 
         /**
-         * @brief 
+         * @brief Store a frame as compact depth frame
+         * 
+         * @param cloud Organized cloud
+         */
+        void enqueue(const pcl::PointCloud<PointType> &cloud);
+        /**
+         * @brief Store a planar frame as compact depth frame
+         * 
+         * @param frame Organized planar frame
+         */
+        void enqueue(const nimbus::SoAFrame &frame);
+        /**
+         * @brief Mean of the queued frames in depth space, empties the queue
          * 
          * @param res 
          */
         void meanFilter(pcl::PointCloud<PointType> &res);
+        /**
+         * @brief Amplitude weighted mean with per pixel outlier rejection, empties the queue
+         * 
+         * @param res Fused cloud
+         * @param confidence Per pixel confidence in [0, 1]
+         */
+        void confidenceFilter(pcl::PointCloud<PointType> &res, std::vector<float> &confidence);
         /**
          * @brief 
          * 
@@ -48,63 +76,55 @@ class cloudUtilities
                                  const boost::shared_ptr< const pcl::PointCloud<PointType>> &raw,
                                  double tolerence,
                                  pcl::PointCloud<PointType> &model);
+        /**
+         * @brief Foreground above the table plane of the frame, no ground truth capture needed.
+         * The plane of the previous call is used as warm start.
+         * 
+         * @param raw Organized cloud
+         * @param margin Minimum height above the table
+         * @param model Organized foreground, NaN elsewhere
+         * @return false if no table plane was found
+         */
+        bool modelFromPlane(const pcl::PointCloud<PointType> &raw, double margin, pcl::PointCloud<PointType> &model);
 
 };
 
 template <class PointType>
-cloudUtilities<PointType>::cloudUtilities(){}
+cloudUtilities<PointType>::cloudUtilities(): _rays(new nimbus::RayTable()){}
 template <class PointType>
 cloudUtilities<PointType>::~cloudUtilities(){}
 
+template <class PointType>
+void cloudUtilities<PointType>::enqueue(const pcl::PointCloud<PointType> &cloud){
+    // Queued frames keep their table when the layout changes
+    if(!_rays->matches(cloud.width, cloud.height)) _rays.reset(new nimbus::RayTable());
+    _rays->update(cloud);
+    nimbus::DepthFrame frame;
+    if(frame.fromCloud(cloud, _rays)) _queue.enqueue(frame);
+}
+
+template <class PointType>
+void cloudUtilities<PointType>::enqueue(const nimbus::SoAFrame &frame){
+    if(!_rays->matches(frame.width(), frame.height())) _rays.reset(new nimbus::RayTable());
+    nimbus::DepthFrame depth;
+    if(frame.toDepthFrame(_rays, depth)) _queue.enqueue(depth);
+}
+
 template <class PointType>
 void cloudUtilities<PointType>::meanFilter(pcl::PointCloud<PointType> &res){
-    if(_queue.isEmpty()) return;
-    typename pcl::PointCloud<PointType>::Ptr tempC (new pcl::PointCloud<PointType>());
-    _queue.dequeue(*tempC);
-    int width = tempC->width;
-    int height = tempC->height;
-    std::vector<float> conf(width*height, 0);
-    std::vector<float> mnCounter(width*height, 0);
-    std::vector<float> addX(width*height, 0);
-    std::vector<float> addY(width*height, 0);
-    std::vector<float> addZ(width*height, 0);
-    std::vector<float> ampt(width*height, 0);
-    //Point_Cloud sum;
-    
-    res.width = width;
-    res.height = height;
+    nimbus::DepthFrame mean;
+    if(!nimbus::meanDepth(_queue, mean)) return;
+    mean.toCloud(res);
+}
+
+template <class PointType>
+void cloudUtilities<PointType>::confidenceFilter(pcl::PointCloud<PointType> &res, std::vector<float> &confidence){
+    std::vector<nimbus::DepthFrame> frames;
     while (!_queue.isEmpty()){
-        int i = 0;
-        for(int i = 0; i < tempC->points.size(); i++){
-            if(!std::isnan(tempC->points[i].z)){
-                addX[i] += tempC->points[i].x;
-                addY[i] += tempC->points[i].y;
-                addZ[i] += tempC->points[i].z;
-                ampt[i] += tempC->points[i].intensity;
-                mnCounter[i] +=1;
-            }else{
-                conf[i] = 1;
-                mnCounter[i] = 0;
-            }
-        }
-        _queue.dequeue(*tempC);
-    }
-    for(int i = 0; i < mnCounter.size(); i++){
-        PointType temPoint;
-        if(mnCounter[i] == 0){
-            temPoint.x = NAN;
-            temPoint.y = NAN;
-            temPoint.z = NAN;
-            temPoint.intensity = NAN;
-        }else{
-            temPoint.x = addX[i] / mnCounter[i];
-            temPoint.y = addY[i] / mnCounter[i];
-            temPoint.z = addZ[i] / mnCounter[i];
-            temPoint.intensity = ampt[i] / mnCounter[i];
-        }
-        res.points.push_back(temPoint);
+        frames.push_back(nimbus::DepthFrame());
+        _queue.dequeue(frames.back());
     }
-    res.is_dense = false;
+    _fusion.fuse(frames, res, confidence);
 }
 
 template <class PointType>
@@ -144,8 +164,16 @@ void cloudUtilities<PointType>::outlineRemover(const boost::shared_ptr< const pc
             }
         }
     }
-    res.width = res.points.size();
-    res.height = 1;
+    // Keep the cropped window organized for the depth image filters
+    int rows = hUpper - hLower - 1;
+    int cols = wUpper - wLower - 1;
+    if(rows > 0 && cols > 0 && res.points.size() == static_cast<std::size_t>(rows * cols)){
+        res.width = cols;
+        res.height = rows;
+    }else{
+        res.width = res.points.size();
+        res.height = 1;
+    }
 }
 
 template <class PointType>
@@ -191,4 +219,17 @@ void cloudUtilities<PointType>::modelFromGroudtruth(const boost::shared_ptr< con
     pcl::copyPointCloud(*edit_cloud, model);
 }
 
+template <class PointType>
+bool cloudUtilities<PointType>::modelFromPlane(const pcl::PointCloud<PointType> &raw, double margin, pcl::PointCloud<PointType> &model)
+{
+    nimbus::SoAFrame frame;
+    nimbus::Bitmask mask;
+    frame.fromCloud(raw);
+    _table.setMargin(static_cast<float>(margin));
+    const bool found = _table.foreground(frame, mask);
+    frame.valid = mask;
+    frame.toCloud(model);
+    return found;
+}
+
 #endif  //UTILITIES_H
\ No newline at end of file
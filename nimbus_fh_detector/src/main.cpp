@@ -1,8 +1,11 @@
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <thread>
 
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/Image.h>
 #include <tf2_ros/static_transform_broadcaster.h>
 #include <tf2_ros/transform_broadcaster.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
@@ -18,7 +21,9 @@
 #include <pcl/filters/filter.h>
 #include <pcl/io/impl/synchronized_queue.hpp>
 
+#include <nimbus_common/confidence_image.hpp>
 #include <nimbus_fh_detector/utilities.h>
+#include <nimbus_fh_detector/filters.h>
 #include <nimbus_fh_detector/recognition.hpp>
 
 typedef pcl::PointXYZI PointType;
@@ -28,11 +33,25 @@ class Detector : public nimbus::Recognition{
     private:
         ros::NodeHandle _nh; 
         ros::Subscriber _sub;
+        ros::Subscriber _subAmbiguous;
         ros::Publisher _pub;
-        PointCloud::Ptr _cloud;
+        ros::Publisher _pubConfidence;
+        nimbus::SoAFrame _input, _cropped;
         bool _newCloud = false;
+        // Sensor time of the latest frame
+        ros::Time _stamp;
+        // "on_demand": only blobs the box_detector SKU classifier could not settle are recognized
+        bool _onDemand;
+        // Ambiguous blobs in arrival order, several boxes of one frame come in a burst
+        std::mutex _ambiguousLock;
+        std::deque<PointCloud::Ptr> _ambiguous;
 
         cloudUtilities<pcl::PointXYZI> _util;
+        nimbus::Filters<pcl::PointXYZI> _filter;
+        // "mean" averages more than 5 frames, "bilateral" smooths 2 frames in the depth image,
+        // "confidence" fuses 3 frames weighted by the amplitude
+        std::string _smoothing;
+        std::vector<float> _confidence;
         tf2_ros::StaticTransformBroadcaster staticTF;
         geometry_msgs::TransformStamped camera;
         
@@ -43,6 +62,15 @@ class Detector : public nimbus::Recognition{
         {
             _sub = _nh.subscribe<sensor_msgs::PointCloud2>("/nimbus/pointcloud", 10, boost::bind(&Detector::callback, this, _1));
             _pub = _nh.advertise<PointCloud>("filtered_cloud", 5);
+            _pubConfidence = _nh.advertise<sensor_msgs::Image>("confidence", 5);
+            _nh.param<std::string>("smoothing", _smoothing, "mean");
+            _nh.param("on_demand", _onDemand, false);
+            if(_onDemand)
+            {
+                std::string topic;
+                _nh.param<std::string>("escalation_topic", topic, "/box_detector_node/sku_ambiguous");
+                _subAmbiguous = _nh.subscribe<pcl::PointCloud<pcl::PointXYZ>>(topic, 5, boost::bind(&Detector::ambiguousCallback, this, _1));
+            }
             camera.header.frame_id = "iiwa_link_0";
             camera.child_frame_id = "camera";
             camera.transform.translation.x = 0.9;
@@ -58,36 +86,97 @@ class Detector : public nimbus::Recognition{
 
         void callback(const sensor_msgs::PointCloud2::ConstPtr &msg)
         {
-            _cloud.reset(new PointCloud());
+            if(_onDemand) return;
             pcl::PointCloud<pcl::PointXYZI>::Ptr blob (new pcl::PointCloud<pcl::PointXYZI>());
             pcl::PCLPointCloud2 pcl_pc2;
             pcl_conversions::toPCL(*msg, pcl_pc2);
             pcl::fromPCLPointCloud2(pcl_pc2, *blob);
-            _cloud->is_dense = false;
-            _util.outlineRemover(blob, blob->width, blob->height, 0.65, 0.65, *_cloud);
-            _util._queue.enqueue(*_cloud);
+            // Crop on the planar frame, no intermediate cloud
+            _input.fromCloud(*blob);
+            _input.crop(0.65, 0.65, _cropped);
+            _util.enqueue(_cropped);
+            _stamp = msg->header.stamp;
             _newCloud = true;        
         }
 
+        void ambiguousCallback(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &msg)
+        {
+            PointCloud::Ptr blob (new PointCloud());
+            pcl::copyPointCloud(*msg, *blob);
+            std::lock_guard<std::mutex> lock(_ambiguousLock);
+            // The recognition is slower than the sensor, old blobs show boxes that may be gone
+            if(_ambiguous.size() >= 16)
+            {
+                ROS_WARN_THROTTLE(5, "Recognition falls behind, dropping the oldest ambiguous blob");
+                _ambiguous.pop_front();
+            }
+            _ambiguous.push_back(blob);
+        }
+
+        /** Per pixel confidence of the fused frame, stamped with the sensor time of the cloud */
+        void publishConfidence(const PointCloud &cloud)
+        {
+            sensor_msgs::Image map;
+            if(nimbus::confidenceImage(cloud, _confidence, "camera", map)) _pubConfidence.publish(map);
+        }
+
         void run()
         {   
             this->constructModelParam();
             ros::spinOnce();
+            ros::Rate rate(30);
             while(ros::ok())
             {  
-                if(_newCloud)
+                if(_onDemand)
+                {
+                    // Blob of an ambiguous box, already background free and averaged
+                    PointCloud::Ptr blob;
+                    {
+                        std::lock_guard<std::mutex> lock(_ambiguousLock);
+                        if(!_ambiguous.empty())
+                        {
+                            blob = _ambiguous.front();
+                            _ambiguous.pop_front();
+                        }
+                    }
+                    if(blob)
+                    {
+                        ros::Time stamp;
+                        pcl_conversions::fromPCL(blob->header.stamp, stamp);
+                        this->cloudHough3D(blob, stamp);
+                    }
+                    camera.header.stamp = ros::Time::now();
+                    staticTF.sendTransform(camera);
+                    ros::spinOnce();
+                    // Next blob without a pause, otherwise wait for the box_detector
+                    if(!blob) rate.sleep();
+                }else if(_newCloud)
                 {
                     _newCloud = false;
                     PointCloud::Ptr blob (new PointCloud());
 
+                    const bool bilateral = (_smoothing == "bilateral");
+                    const bool confidence = (_smoothing == "confidence");
+                    const int min_frames = bilateral ? 1 : (confidence ? 2 : 5);
                     int queue_size = _util._queue.size();
-                    while (!(queue_size > 5) ){
+                    while (!(queue_size > min_frames) ){
                         queue_size = _util._queue.size();
                         ros::spinOnce();
                     }
-                    _util.meanFilter(*blob);
+                    if(confidence)
+                    {
+                        _util.confidenceFilter(*blob, _confidence);
+                        publishConfidence(*blob);
+                    }
+                    else _util.meanFilter(*blob);
+                    if(bilateral){
+                        PointCloud::Ptr smooth (new PointCloud());
+                        _filter.bilateralDepth(blob, *smooth);
+                        blob = smooth;
+                    }
                     
-                    this->cloudHough3D(blob);
+                    // Newest frame of the average
+                    this->cloudHough3D(blob, _stamp);
 
                     ros::Duration(2).sleep();
                     blob->header.frame_id = "camera";
@@ -100,6 +189,7 @@ class Detector : public nimbus::Recognition{
                     camera.header.stamp = ros::Time::now();
                     staticTF.sendTransform(camera);
                     ros::spinOnce();
+                    rate.sleep();
                 }
             }
         }
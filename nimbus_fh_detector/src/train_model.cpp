@@ -33,12 +33,15 @@ class ModelTraining : public cloudUtilities<pcl::PointXYZI>
         tf2_ros::StaticTransformBroadcaster _staticTrans;
         geometry_msgs::TransformStamped _cameraPose;
         std::string _working_dir;
+        // Segment the model against the fitted table plane instead of the first capture
+        bool _tablePlane;
 
     public: 
         ModelTraining(ros::NodeHandle nh, std::string work_dir): _nh(nh), 
                                            save_point_cloud(false), 
                                            cloudUtilities<pcl::PointXYZI>()
         {
+            ros::NodeHandle("~").param("table_plane", _tablePlane, false);
             _sub = _nh.subscribe<sensor_msgs::PointCloud2>("/nimbus/pointcloud", 10 , boost::bind(&ModelTraining::Callback, this, _1));
             _pub = _nh.advertise<pcl::PointCloud<pcl::PointXYZI>>("filtered_cloud", 5);
             _sub_save = nh.subscribe<std_msgs::Bool>("save_pointcloud", 10, boost::bind(&ModelTraining::saveCallback, this, _1));
@@ -64,7 +67,7 @@ class ModelTraining : public cloudUtilities<pcl::PointXYZI>
             pcl::fromPCLPointCloud2(pcl_pc2, *blob);
             this->outlineRemover(blob, blob->width, blob->height, 0.67, 0.67, *blob_removed);
             blob_removed->is_dense = false;
-            this->_queue.enqueue(*blob_removed);
+            this->enqueue(*blob_removed);
         }
 
         void saveCallback(const std_msgs::Bool::ConstPtr &msg)
@@ -100,7 +103,14 @@ class ModelTraining : public cloudUtilities<pcl::PointXYZI>
                         save_point_cloud = false;
                         std::stringstream ss;
                         ss << test_dir.c_str() << model_name;
-                        if (counter == 0){
+                        if (_tablePlane){
+                            ss << std::to_string(counter) << extention;
+                            if(this->modelFromPlane(*_cloud, 0.03, *_model)){
+                                pcl::io::savePCDFileASCII(ss.str(), *_model);
+                                ROS_WARN("Saved PCD file path: %s", ss.str().c_str());
+                                counter += 1;
+                            }else ROS_ERROR("No table plane found, model not saved");
+                        }else if (counter == 0){
                             ss << std::to_string(counter) << extention;
                             saved_groudtruth = ss.str();
                             pcl::io::savePCDFileASCII(ss.str(), *_cloud);
@@ -122,8 +132,9 @@ class ModelTraining : public cloudUtilities<pcl::PointXYZI>
                     _pub.publish(_cloud);
 
                     if(queue_size > 100){
+                        nimbus::DepthFrame dropped;
                         while(!this->_queue.isEmpty()){
-                            this->_queue.dequeue(*_cloud);
+                            this->_queue.dequeue(dropped);
                         }
                     }
                 }